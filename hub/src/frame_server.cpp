@@ -0,0 +1,147 @@
+#include "frame_server.h"
+#include "hub_log.h"
+#include "data/crc32.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+static const int CLIENT_TIMEOUT_MS = 2000;
+
+FrameServer::FrameServer() : listenFd(-1), running(false), frame(), hasFrame(false) {
+}
+
+FrameServer::~FrameServer() {
+    stop();
+}
+
+bool FrameServer::start(const std::string& bindAddress, int port) {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        HUB_LOGE("server", "socket() failed: %s", strerror(errno));
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, bindAddress.c_str(), &addr.sin_addr) != 1) {
+        HUB_LOGE("server", "Invalid bind address: %s", bindAddress.c_str());
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 8) != 0) {
+        HUB_LOGE("server", "Cannot listen on %s:%d: %s", bindAddress.c_str(), port, strerror(errno));
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    running = true;
+    thread = std::thread(&FrameServer::run, this);
+    HUB_LOGI("server", "Listening on %s:%d", bindAddress.c_str(), port);
+    return true;
+}
+
+void FrameServer::stop() {
+    running = false;
+    if (thread.joinable()) thread.join();
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+    }
+}
+
+void FrameServer::publish(const CompactDashboard& next) {
+    std::lock_guard<std::mutex> lock(frameMutex);
+    frame = next;
+    hasFrame = true;
+}
+
+void FrameServer::run() {
+    while (running) {
+        // Poll with a timeout so stop() is noticed within a second
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) <= 0) continue;
+
+        sockaddr_in peer;
+        socklen_t peerLen = sizeof(peer);
+        int fd = accept(listenFd, (sockaddr*)&peer, &peerLen);
+        if (fd < 0) continue;
+
+        char peerName[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &peer.sin_addr, peerName, sizeof(peerName));
+        HUB_LOGI("server", "Request from %s", peerName);
+
+        serveClient(fd);
+        close(fd);
+    }
+}
+
+static bool readExact(int fd, void* buffer, size_t len) {
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    size_t received = 0;
+    while (received < len) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, CLIENT_TIMEOUT_MS) <= 0) return false;
+        ssize_t n = recv(fd, out + received, len - received, 0);
+        if (n <= 0) return false;
+        received += n;
+    }
+    return true;
+}
+
+void FrameServer::serveClient(int fd) {
+    HubRequest request;
+    if (!readExact(fd, &request, sizeof(request))) {
+        HUB_LOGW("server", "Incomplete request");
+        return;
+    }
+    if (request.magic != HUB_MAGIC || request.version != HUB_PROTOCOL_VERSION) {
+        HUB_LOGW("server", "Unsupported request (magic %08x, version %u)",
+                 (unsigned)request.magic, (unsigned)request.version);
+        return;
+    }
+
+    // Header and payload in one buffer so they leave in a single segment
+    uint8_t buffer[sizeof(HubFrameHeader) + sizeof(CompactDashboard)];
+    HubFrameHeader header = {};
+    header.magic = HUB_MAGIC;
+    header.version = HUB_PROTOCOL_VERSION;
+    header.length = sizeof(CompactDashboard);
+    {
+        std::lock_guard<std::mutex> lock(frameMutex);
+        if (!hasFrame) {
+            HUB_LOGW("server", "No data yet, closing");
+            return;
+        }
+        memcpy(buffer + sizeof(header), &frame, sizeof(frame));
+    }
+    header.crc = crc32(buffer + sizeof(header), sizeof(CompactDashboard));
+    header.serverTime = (uint32_t)time(nullptr);
+    memcpy(buffer, &header, sizeof(header));
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    size_t sent = 0;
+    while (sent < sizeof(buffer)) {
+        ssize_t n = send(fd, buffer + sent, sizeof(buffer) - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            HUB_LOGW("server", "Send failed: %s", strerror(errno));
+            return;
+        }
+        sent += n;
+    }
+}
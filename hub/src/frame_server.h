@@ -0,0 +1,37 @@
+#ifndef HUB_FRAME_SERVER_H
+#define HUB_FRAME_SERVER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "data/hub_protocol.h"
+
+// TCP server handing the current CompactDashboard frame to displays. Each
+// connection is one request/response; the server thread never touches the
+// upstream APIs, so a slow met.no response cannot delay a waking display.
+class FrameServer {
+public:
+    FrameServer();
+    ~FrameServer();
+
+    bool start(const std::string& bindAddress, int port);
+    void stop();
+
+    // Replace the frame served to displays
+    void publish(const CompactDashboard& frame);
+
+private:
+    void run();
+    void serveClient(int fd);
+
+    int listenFd;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    std::mutex frameMutex;
+    CompactDashboard frame;
+    bool hasFrame;
+};
+
+#endif  // HUB_FRAME_SERVER_H
@@ -0,0 +1,106 @@
+#include "http_client.h"
+#include "hub_log.h"
+#include "time/civil_time.h"
+#include <curl/curl.h>
+#include <algorithm>
+#include <cctype>
+
+static size_t writeBody(char* data, size_t size, size_t count, void* userdata) {
+    static_cast<std::string*>(userdata)->append(data, size * count);
+    return size * count;
+}
+
+static size_t writeHeader(char* data, size_t size, size_t count, void* userdata) {
+    auto* headers = static_cast<std::map<std::string, std::string>*>(userdata);
+    std::string line(data, size * count);
+
+    size_t colon = line.find(':');
+    if (colon != std::string::npos) {
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+
+        size_t start = line.find_first_not_of(" \t", colon + 1);
+        size_t end = line.find_last_not_of(" \t\r\n");
+        (*headers)[name] = (start != std::string::npos && end >= start)
+                         ? line.substr(start, end - start + 1) : std::string();
+    }
+    return size * count;
+}
+
+HttpClient::HttpClient(const std::string& userAgent) : curl(curl_easy_init()), userAgent(userAgent) {
+}
+
+HttpClient::~HttpClient() {
+    if (curl) curl_easy_cleanup(curl);
+}
+
+bool HttpClient::perform(const std::string& url, const std::vector<std::string>& headers,
+                         const std::string* postBody, HttpResponse& response) {
+    if (!curl) {
+        HUB_LOGE("http", "curl not initialized");
+        return false;
+    }
+
+    response = HttpResponse();
+    curl_easy_reset(curl);
+
+    struct curl_slist* headerList = nullptr;
+    for (const std::string& header : headers) {
+        headerList = curl_slist_append(headerList, header.c_str());
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, userAgent.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerList);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");  // Any encoding curl supports
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, writeHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
+
+    if (postBody) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postBody->c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)postBody->size());
+    }
+
+    CURLcode result = curl_easy_perform(curl);
+    curl_slist_free_all(headerList);
+
+    if (result != CURLE_OK) {
+        HUB_LOGE("http", "Request failed: %s", curl_easy_strerror(result));
+        return false;
+    }
+
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+
+    double totalSec = 0;
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &totalSec);
+    HUB_LOGI("http", "HTTP %ld, %zu bytes in %d ms", response.status,
+             response.body.size(), (int)(totalSec * 1000));
+    return true;
+}
+
+bool HttpClient::get(const std::string& url, const std::vector<std::string>& headers,
+                     HttpResponse& response) {
+    return perform(url, headers, nullptr, response);
+}
+
+bool HttpClient::postForm(const std::string& url, const std::string& body, HttpResponse& response) {
+    return perform(url, {"Content-Type: application/x-www-form-urlencoded"}, &body, response);
+}
+
+std::string HttpClient::escape(const std::string& value) {
+    char* escaped = curl ? curl_easy_escape(curl, value.c_str(), (int)value.size()) : nullptr;
+    if (!escaped) return value;
+    std::string result(escaped);
+    curl_free(escaped);
+    return result;
+}
+
+time_t parseHttpDate(const std::string& value) {
+    return (time_t)CivilTime::parseRFC1123(value.c_str());
+}
@@ -0,0 +1,49 @@
+#ifndef HUB_HTTP_CLIENT_H
+#define HUB_HTTP_CLIENT_H
+
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef void CURL;
+
+struct HttpResponse {
+    long status = 0;
+    std::string body;
+    std::map<std::string, std::string> headers;  // Names lower-cased
+
+    std::string header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it != headers.end() ? it->second : std::string();
+    }
+};
+
+// Thin libcurl wrapper. Keeps one easy handle so TLS sessions and
+// connections to the same host are reused between polls.
+class HttpClient {
+public:
+    explicit HttpClient(const std::string& userAgent);
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    bool get(const std::string& url, const std::vector<std::string>& headers, HttpResponse& response);
+    bool postForm(const std::string& url, const std::string& body, HttpResponse& response);
+
+    // URL-encode a query or form value
+    std::string escape(const std::string& value);
+
+private:
+    bool perform(const std::string& url, const std::vector<std::string>& headers,
+                 const std::string* postBody, HttpResponse& response);
+
+    CURL* curl;
+    std::string userAgent;
+};
+
+// Parse an RFC 1123 date ("Thu, 26 Dec 2025 14:00:00 GMT"), 0 on failure
+time_t parseHttpDate(const std::string& value);
+
+#endif  // HUB_HTTP_CLIENT_H
@@ -0,0 +1,67 @@
+#include "hub_config.h"
+#include "hub_log.h"
+#include <fstream>
+#include <cstdlib>
+
+static std::string trim(const std::string& value) {
+    size_t start = value.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = value.find_last_not_of(" \t\r\n");
+    std::string result = value.substr(start, end - start + 1);
+
+    if (result.size() >= 2 && (result.front() == '"' || result.front() == '\'') &&
+        result.back() == result.front()) {
+        result = result.substr(1, result.size() - 2);
+    }
+    return result;
+}
+
+bool loadConfig(const std::string& path, HubConfig& config) {
+    std::ifstream file(path);
+    if (!file) {
+        HUB_LOGE("config", "Cannot open config file: %s", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        if (trim(line).empty()) continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            HUB_LOGW("config", "%s:%d: ignoring line without '='", path.c_str(), lineNumber);
+            continue;
+        }
+
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+
+        if (key == "NETATMO_CLIENT_ID") config.clientId = value;
+        else if (key == "NETATMO_CLIENT_SECRET") config.clientSecret = value;
+        else if (key == "NETATMO_REFRESH_TOKEN") config.refreshToken = value;
+        else if (key == "NETATMO_DEVICE_ID") config.deviceId = value;
+        else if (key == "LOCATION_LAT") config.latitude = atof(value.c_str());
+        else if (key == "LOCATION_LON") config.longitude = atof(value.c_str());
+        else if (key == "HTTP_USER_AGENT") config.userAgent = value;
+        else if (key == "TIMEZONE") config.timezone = value;
+        else if (key == "STATE_FILE") config.stateFile = value;
+        else if (key == "HUB_BIND") config.bindAddress = value;
+        else if (key == "HUB_PORT") config.port = atoi(value.c_str());
+        else if (key == "NETATMO_POLL_DELAY_SEC") config.netatmoPollDelaySec = atoi(value.c_str());
+        else if (key == "RETRY_SEC") config.retrySec = atoi(value.c_str());
+        else HUB_LOGW("config", "%s:%d: unknown key %s", path.c_str(), lineNumber, key.c_str());
+    }
+
+    if (config.clientId.empty() || config.clientSecret.empty() ||
+        config.refreshToken.empty() || config.deviceId.empty()) {
+        HUB_LOGE("config", "NETATMO_CLIENT_ID, NETATMO_CLIENT_SECRET, NETATMO_REFRESH_TOKEN "
+                 "and NETATMO_DEVICE_ID are required");
+        return false;
+    }
+
+    return true;
+}
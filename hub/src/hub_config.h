@@ -0,0 +1,28 @@
+#ifndef HUB_CONFIG_H
+#define HUB_CONFIG_H
+
+#include <string>
+#include "data/hub_protocol.h"
+
+// Daemon configuration. Keys in the config file use the same names as the
+// firmware's config.h (NETATMO_CLIENT_ID, LOCATION_LAT, ...).
+struct HubConfig {
+    std::string clientId;
+    std::string clientSecret;
+    std::string refreshToken;
+    std::string deviceId;
+    double latitude = 46.8042;
+    double longitude = 9.8565;
+    std::string userAgent = "M5Paper-Netatmo-Hub/1.0";
+    std::string timezone = "CET-1CEST,M3.5.0,M10.5.0/3";  // POSIX TZ for day aggregation
+    std::string stateFile = "netatmo-hub.state";          // Rotated refresh token
+    std::string bindAddress = "0.0.0.0";
+    int port = HUB_DEFAULT_PORT;
+    int netatmoPollDelaySec = 630;  // Poll this long after a measurement (displays wake at +660)
+    int retrySec = 120;             // Retry interval after failures
+};
+
+// Load "KEY = value" lines ('#' starts a comment, values may be quoted)
+bool loadConfig(const std::string& path, HubConfig& config);
+
+#endif  // HUB_CONFIG_H
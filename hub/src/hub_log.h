@@ -0,0 +1,13 @@
+#ifndef HUB_LOG_H
+#define HUB_LOG_H
+
+#include <cstdio>
+
+// Same "[level][tag] message" shape as the firmware's ESP_LOGx output.
+// Timestamps are added by journald / the service manager.
+#define HUB_LOG(level, tag, fmt, ...) fprintf(stderr, "[" level "][%s] " fmt "\n", tag, ##__VA_ARGS__)
+#define HUB_LOGI(tag, fmt, ...) HUB_LOG("I", tag, fmt, ##__VA_ARGS__)
+#define HUB_LOGW(tag, fmt, ...) HUB_LOG("W", tag, fmt, ##__VA_ARGS__)
+#define HUB_LOGE(tag, fmt, ...) HUB_LOG("E", tag, fmt, ##__VA_ARGS__)
+
+#endif  // HUB_LOG_H
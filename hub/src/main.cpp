@@ -0,0 +1,119 @@
+/**
+ * Netatmo Hub - LAN companion for the M5Paper dashboard
+ *
+ * Polls Netatmo and met.no on behalf of all displays and serves the
+ * aggregated dashboard as one small binary frame (../src/data/hub_protocol.h).
+ * Displays with HUB_HOST set fetch this frame over plain TCP instead of
+ * making their own HTTPS requests.
+ */
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <curl/curl.h>
+#include "hub_config.h"
+#include "hub_log.h"
+#include "http_client.h"
+#include "netatmo_source.h"
+#include "metno_source.h"
+#include "frame_server.h"
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void handleSignal(int) {
+    stopRequested = 1;
+}
+
+static int localDay(time_t t) {
+    struct tm tm;
+    localtime_r(&t, &tm);
+    return tm.tm_year * 1000 + tm.tm_yday;
+}
+
+int main(int argc, char** argv) {
+    const char* configPath = "/etc/netatmo-hub.conf";
+    int opt;
+    while ((opt = getopt(argc, argv, "c:h")) != -1) {
+        if (opt == 'c') {
+            configPath = optarg;
+        } else {
+            fprintf(stderr, "Usage: %s [-c config]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    HubConfig config;
+    if (!loadConfig(configPath, config)) {
+        return 1;
+    }
+
+    // Day aggregation uses the display's timezone, not the host's
+    setenv("TZ", config.timezone.c_str(), 1);
+    tzset();
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    {
+        HttpClient http(config.userAgent);
+        NetatmoSource netatmo(config, http);
+        MetnoSource metno(config, http);
+        FrameServer server;
+
+        if (!server.start(config.bindAddress, config.port)) {
+            curl_global_cleanup();
+            return 1;
+        }
+
+        CompactDashboard frame;
+        memset(&frame, 0, sizeof(frame));
+        bool haveNetatmo = false;
+        time_t nextNetatmo = 0;
+        int aggregatedDay = -1;
+
+        while (!stopRequested) {
+            time_t now = time(nullptr);
+            bool changed = false;
+
+            if (now >= nextNetatmo) {
+                if (netatmo.update(frame)) {
+                    haveNetatmo = true;
+                    changed = true;
+                    // Netatmo uploads every 10 minutes; poll shortly after the next one
+                    nextNetatmo = netatmo.getMeasurementTime() + config.netatmoPollDelaySec;
+                    if (nextNetatmo <= now) nextNetatmo = now + 60;  // Upload late, retry soon
+                } else {
+                    nextNetatmo = now + config.retrySec;
+                }
+            }
+
+            if (now >= metno.getNextFetch() && metno.fetch()) {
+                aggregatedDay = -1;
+            }
+
+            // Re-aggregate on new data and at local midnight
+            if (metno.hasData() && aggregatedDay != localDay(now)) {
+                metno.aggregate(frame, now);
+                aggregatedDay = localDay(now);
+                changed = true;
+            }
+
+            if (changed && haveNetatmo) {
+                server.publish(frame);
+                HUB_LOGI("main", "Frame published (Netatmo %lu, next poll in %ld sec)",
+                         (unsigned long)frame.timestamp, (long)(nextNetatmo - now));
+            }
+
+            sleep(1);
+        }
+
+        HUB_LOGI("main", "Shutting down");
+        server.stop();
+    }
+
+    curl_global_cleanup();
+    return 0;
+}
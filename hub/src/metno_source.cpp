@@ -0,0 +1,153 @@
+#include "metno_source.h"
+#include "hub_log.h"
+#include "time/civil_time.h"
+#include "data/daily_summary.h"
+#include "data/weather_symbols.h"
+#include <json/json.h>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+static const char* FORECAST_URL = "https://api.met.no/weatherapi/locationforecast/2.0/compact";
+static const int DEFAULT_EXPIRY_SEC = 1800;
+
+// Local time via libc (TZ of the hub host)
+static time_t localStartOfDay(time_t utc) {
+    struct tm local;
+    localtime_r(&utc, &local);
+    local.tm_hour = 0;
+    local.tm_min = 0;
+    local.tm_sec = 0;
+    local.tm_isdst = -1;
+    return mktime(&local);
+}
+
+static uint8_t localHour(time_t utc) {
+    struct tm local;
+    localtime_r(&utc, &local);
+    return (uint8_t)local.tm_hour;
+}
+
+static const DailySummary::Clock LOCAL_CLOCK = {localStartOfDay, localHour};
+
+MetnoSource::MetnoSource(const HubConfig& config, HttpClient& http)
+    : config(config), http(http), nextFetch(0) {
+}
+
+bool MetnoSource::fetch() {
+    char url[160];
+    snprintf(url, sizeof(url), "%s?lat=%.4f&lon=%.4f", FORECAST_URL,
+             config.latitude, config.longitude);
+    HUB_LOGI("meteo", "URL: %s", url);
+
+    std::vector<std::string> headers;
+    if (!lastModified.empty() && series.count > 0) {
+        headers.push_back("If-Modified-Since: " + lastModified);
+    }
+
+    time_t now = time(nullptr);
+    HttpResponse response;
+    if (!http.get(url, headers, response)) {
+        nextFetch = now + config.retrySec;
+        return false;
+    }
+
+    time_t expires = parseHttpDate(response.header("expires"));
+    nextFetch = expires > now ? expires : now + DEFAULT_EXPIRY_SEC;
+
+    if (response.status == 304) {
+        HUB_LOGI("meteo", "304 Not Modified, next fetch in %ld sec", (long)(nextFetch - now));
+        return false;
+    }
+
+    if (response.status != 200) {
+        if (response.status == 429) HUB_LOGE("meteo", "429 Throttling! Too many requests");
+        else if (response.status == 403) HUB_LOGE("meteo", "403 Forbidden! Check User-Agent header");
+        else HUB_LOGE("meteo", "HTTP error: %ld", response.status);
+        nextFetch = now + std::max(config.retrySec, 600);
+        return false;
+    }
+
+    if (!parse(response.body)) {
+        nextFetch = now + config.retrySec;
+        return false;
+    }
+
+    lastModified = response.header("last-modified");
+    HUB_LOGI("meteo", "Forecast updated: %u points, next fetch in %ld sec",
+             series.count, (long)(nextFetch - now));
+    return true;
+}
+
+bool MetnoSource::parse(const std::string& body) {
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if (!reader->parse(body.data(), body.data() + body.size(), &root, &errors)) {
+        HUB_LOGE("meteo", "JSON parse error: %s", errors.c_str());
+        return false;
+    }
+
+    const Json::Value& timeseries = root["properties"]["timeseries"];
+    if (!timeseries.isArray() || timeseries.empty()) {
+        HUB_LOGE("meteo", "No timeseries in response");
+        return false;
+    }
+
+    // Same window as the display: from local midnight up to the series horizon
+    time_t todayStart = localStartOfDay(time(nullptr));
+    time_t seriesEnd = todayStart + HOURLY_SERIES_HORIZON_H * 3600;
+
+    HourlySeries parsed;
+    for (const Json::Value& ts : timeseries) {
+        time_t entryTime = (time_t)CivilTime::parseISO8601(ts["time"].asString().c_str());
+        if (entryTime == 0) continue;
+
+        // Timeseries is chronological: stop at the horizon
+        if (entryTime >= seriesEnd) break;
+        if (entryTime < todayStart) continue;
+
+        const Json::Value& instant = ts["data"]["instant"]["details"];
+        if (!instant.isObject()) continue;
+
+        float precip = 0;
+        uint8_t code = HOURLY_NO_SYMBOL;
+        const Json::Value& next1h = ts["data"]["next_1_hours"];
+        if (next1h.isObject()) {
+            precip = next1h["details"].get("precipitation_amount", 0.0).asFloat();
+            const Json::Value& symbol = next1h["summary"]["symbol_code"];
+            if (symbol.isString()) {
+                code = MetnoSymbols::parse(symbol.asCString());
+            }
+        }
+
+        if (!parsed.append((uint32_t)entryTime, instant.get("air_temperature", 0.0).asFloat(), precip,
+                           instant.get("wind_speed", 0.0).asFloat(),
+                           (uint16_t)instant.get("wind_from_direction", 0).asDouble(), code)) {
+            break;  // Full
+        }
+    }
+
+    if (parsed.count == 0) {
+        HUB_LOGE("meteo", "No usable timeseries entries");
+        return false;
+    }
+
+    series = parsed;
+    return true;
+}
+
+void MetnoSource::aggregate(CompactDashboard& frame, time_t now) const {
+    if (!DailySummary::build(series, now, LOCAL_CLOCK, frame.forecast)) {
+        HUB_LOGW("meteo", "No forecast data for today");
+        frame.forecast = CompactForecast();
+        return;
+    }
+
+    for (int d = 0; d < 4; d++) {
+        if (!frame.forecast.days[d].valid) {
+            HUB_LOGW("meteo", "Day %d: No valid data", d);
+        }
+    }
+}
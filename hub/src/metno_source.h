@@ -0,0 +1,40 @@
+#ifndef HUB_METNO_SOURCE_H
+#define HUB_METNO_SOURCE_H
+
+#include <ctime>
+#include <string>
+#include "data/hourly_series.h"
+#include "hub_config.h"
+#include "http_client.h"
+
+// met.no locationforecast for the hub. Honours Expires/Last-Modified so all
+// displays together cost one conditional request per forecast update, and
+// keeps the parsed timeseries (the display's HourlySeries) so the day
+// aggregation can be redone at midnight without refetching.
+class MetnoSource {
+public:
+    MetnoSource(const HubConfig& config, HttpClient& http);
+
+    // Fetch the forecast if it changed. Returns true if new data arrived.
+    bool fetch();
+
+    // When the next fetch is due (Expires header, or a retry interval)
+    time_t getNextFetch() const { return nextFetch; }
+
+    bool hasData() const { return series.count > 0; }
+
+    // Fill the forecast part of the frame (4 days from local midnight,
+    // DailySummary as on the display)
+    void aggregate(CompactDashboard& frame, time_t now) const;
+
+private:
+    bool parse(const std::string& body);
+
+    const HubConfig& config;
+    HttpClient& http;
+    HourlySeries series;
+    std::string lastModified;
+    time_t nextFetch;
+};
+
+#endif  // HUB_METNO_SOURCE_H
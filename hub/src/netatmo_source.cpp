@@ -0,0 +1,280 @@
+#include "netatmo_source.h"
+#include "hub_log.h"
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+static const char* TOKEN_URL = "https://api.netatmo.com/oauth2/token";
+static const char* WEATHER_URL = "https://api.netatmo.com/api/getstationsdata";
+static const char* MEASURE_URL = "https://api.netatmo.com/api/getmeasure";
+
+NetatmoSource::NetatmoSource(const HubConfig& config, HttpClient& http)
+    : config(config), http(http), refreshToken(config.refreshToken),
+      tokenExpiry(0), measurementTime(0) {
+    loadRefreshToken();
+}
+
+void NetatmoSource::loadRefreshToken() {
+    std::ifstream file(config.stateFile);
+    std::string token;
+    if (file && std::getline(file, token) && !token.empty()) {
+        refreshToken = token;
+        HUB_LOGI("netatmo", "Using refresh token from %s", config.stateFile.c_str());
+    }
+}
+
+void NetatmoSource::saveRefreshToken() {
+    // Write to a temp file and rename so a crash never leaves a truncated token
+    std::string tmpPath = config.stateFile + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file) {
+            HUB_LOGE("netatmo", "Cannot write %s", tmpPath.c_str());
+            return;
+        }
+        file << refreshToken << "\n";
+        if (!file.flush()) {
+            HUB_LOGE("netatmo", "Failed to write %s", tmpPath.c_str());
+            return;
+        }
+    }
+
+    if (rename(tmpPath.c_str(), config.stateFile.c_str()) != 0) {
+        HUB_LOGE("netatmo", "Cannot replace %s", config.stateFile.c_str());
+    }
+}
+
+bool NetatmoSource::refreshAccessToken() {
+    HUB_LOGI("netatmo", "Refreshing OAuth2 access token");
+
+    std::string form = "grant_type=refresh_token";
+    form += "&refresh_token=" + http.escape(refreshToken);
+    form += "&client_id=" + http.escape(config.clientId);
+    form += "&client_secret=" + http.escape(config.clientSecret);
+
+    HttpResponse response;
+    if (!http.postForm(TOKEN_URL, form, response) || response.status != 200) {
+        HUB_LOGE("netatmo", "Token refresh failed (HTTP %ld)", response.status);
+        return false;
+    }
+
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    const char* begin = response.body.data();
+    if (!reader->parse(begin, begin + response.body.size(), &root, &errors) ||
+        !root["access_token"].isString()) {
+        HUB_LOGE("netatmo", "No access_token in response");
+        return false;
+    }
+
+    accessToken = root["access_token"].asString();
+    int expiresIn = root.get("expires_in", 10800).asInt();  // Default 3 hours
+    tokenExpiry = time(nullptr) + expiresIn;
+
+    // Netatmo rotates refresh tokens; keep the newest one
+    std::string rotated = root.get("refresh_token", "").asString();
+    if (!rotated.empty() && rotated != refreshToken) {
+        refreshToken = rotated;
+        saveRefreshToken();
+        HUB_LOGI("netatmo", "Refresh token rotated");
+    }
+
+    HUB_LOGI("netatmo", "Token refreshed, expires in %d seconds", expiresIn);
+    return true;
+}
+
+bool NetatmoSource::ensureValidToken() {
+    // Check if token is still valid (with 60s buffer)
+    if (!accessToken.empty() && time(nullptr) < tokenExpiry - 60) {
+        return true;
+    }
+    return refreshAccessToken();
+}
+
+bool NetatmoSource::getJSON(const std::string& url, Json::Value& root) {
+    HttpResponse response;
+    if (!http.get(url, {"Authorization: Bearer " + accessToken}, response)) {
+        return false;
+    }
+
+    if (response.status == 401 || response.status == 403) {
+        // Token revoked early; force a refresh on the next call
+        accessToken.clear();
+    }
+    if (response.status != 200) {
+        HUB_LOGE("netatmo", "HTTP error: %ld", response.status);
+        return false;
+    }
+
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    const char* begin = response.body.data();
+    if (!reader->parse(begin, begin + response.body.size(), &root, &errors)) {
+        HUB_LOGE("netatmo", "JSON parse error: %s", errors.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint8_t NetatmoSource::stringToTrend(const std::string& trend) {
+    if (trend == "up") return COMPACT_TREND_UP;
+    if (trend == "down") return COMPACT_TREND_DOWN;
+    if (trend == "stable") return COMPACT_TREND_STABLE;
+    return COMPACT_TREND_UNKNOWN;
+}
+
+uint8_t NetatmoSource::calculateCO2Trend(int currentCO2, time_t measured) {
+    // Same rule as the display: compare with the measurement 10 minutes
+    // earlier, more than 30 ppm difference is a trend
+    time_t tenMinutesAgo = measured - 600;
+
+    std::string url = MEASURE_URL;
+    url += "?device_id=" + http.escape(config.deviceId);
+    url += "&scale=max&type=CO2&limit=1";
+    url += "&date_begin=" + std::to_string(tenMinutesAgo - 300);
+    url += "&date_end=" + std::to_string(tenMinutesAgo + 300);
+
+    Json::Value root;
+    if (!getJSON(url, root)) {
+        HUB_LOGW("netatmo", "Failed to fetch historical CO2 data, defaulting to STABLE");
+        return COMPACT_TREND_STABLE;
+    }
+
+    const Json::Value& values = root["body"][0]["value"][0];
+    if (!values.isArray() || values.empty() || !values[0].isNumeric()) {
+        HUB_LOGW("netatmo", "No historical CO2 data in response, defaulting to STABLE");
+        return COMPACT_TREND_STABLE;
+    }
+
+    int diff = currentCO2 - values[0].asInt();
+    HUB_LOGI("netatmo", "CO2 trend: current %d ppm, diff %+d ppm", currentCO2, diff);
+
+    if (diff > 30) return COMPACT_TREND_UP;
+    if (diff < -30) return COMPACT_TREND_DOWN;
+    return COMPACT_TREND_STABLE;
+}
+
+bool NetatmoSource::update(CompactDashboard& frame) {
+    HUB_LOGI("netatmo", "Fetching weather data");
+
+    if (!ensureValidToken()) {
+        HUB_LOGE("netatmo", "Failed to get valid token");
+        return false;
+    }
+
+    Json::Value root;
+    if (!getJSON(std::string(WEATHER_URL) + "?device_id=" + http.escape(config.deviceId), root)) {
+        HUB_LOGE("netatmo", "Failed to fetch weather data");
+        return false;
+    }
+
+    const Json::Value& devices = root["body"]["devices"];
+    if (!devices.isArray() || devices.empty()) {
+        HUB_LOGE("netatmo", "No devices in response");
+        return false;
+    }
+
+    const Json::Value& device = devices[0];
+    const Json::Value& dashboard = device["dashboard_data"];
+
+    std::string name = device.get("station_name", "Unknown").asString();
+    memset(frame.stationName, 0, sizeof(frame.stationName));
+    strncpy(frame.stationName, name.c_str(), sizeof(frame.stationName) - 1);
+
+    frame.timestamp = dashboard.get("time_utc", 0).asUInt();
+    measurementTime = frame.timestamp;
+
+    // Indoor (main device)
+    CompactIndoor& indoor = frame.indoor;
+    indoor = CompactIndoor();
+    if (dashboard.isObject()) {
+        indoor.temperature = compactDeci(dashboard.get("Temperature", 0.0).asFloat());
+        indoor.humidity = dashboard.get("Humidity", 0).asUInt();
+        indoor.co2 = dashboard.get("CO2", 0).asUInt();
+        indoor.noise = dashboard.get("Noise", 0).asUInt();
+
+        if (dashboard.isMember("Pressure")) {
+            indoor.pressure = dashboard["Pressure"].asUInt();
+        } else if (dashboard.isMember("AbsolutePressure")) {
+            indoor.pressure = dashboard["AbsolutePressure"].asUInt();
+        } else {
+            HUB_LOGW("netatmo", "No pressure field found in dashboard_data");
+        }
+
+        indoor.temperatureTrend = stringToTrend(dashboard.get("temp_trend", "").asString());
+        indoor.pressureTrend = stringToTrend(dashboard.get("pressure_trend", "").asString());
+        indoor.co2Trend = calculateCO2Trend(indoor.co2, frame.timestamp);
+        indoor.minTemp = compactDeci(dashboard.get("min_temp", 0.0).asFloat());
+        indoor.maxTemp = compactDeci(dashboard.get("max_temp", 0.0).asFloat());
+        indoor.minTempAge = compactMinutes(dashboard.get("date_min_temp", 0).asUInt(), frame.timestamp);
+        indoor.maxTempAge = compactMinutes(dashboard.get("date_max_temp", 0).asUInt(), frame.timestamp);
+        indoor.valid = 1;
+
+        HUB_LOGI("netatmo", "Indoor: %.1f°C, %d%% RH, %d ppm CO2, %d mbar",
+                 compactFromDeci(indoor.temperature), indoor.humidity, indoor.co2, indoor.pressure);
+    } else {
+        HUB_LOGW("netatmo", "No dashboard_data in device");
+    }
+
+    const Json::Value& modules = device["modules"];
+    frame.outdoor = CompactOutdoor();
+    frame.wind = CompactWind();
+    frame.rain = CompactRain();
+
+    // One pass over the modules, each sent to its slot by type
+    frame.roomCount = 0;
+    memset(frame.rooms, 0, sizeof(frame.rooms));
+    for (const Json::Value& module : modules) {
+        const Json::Value& data = module["dashboard_data"];
+        if (!data.isObject()) continue;
+
+        const std::string type = module.get("type", "").asString();
+        if (type == "NAModule1" && !frame.outdoor.valid) {
+            CompactOutdoor& outdoor = frame.outdoor;
+            outdoor.temperature = compactDeci(data.get("Temperature", 0.0).asFloat());
+            outdoor.humidity = data.get("Humidity", 0).asUInt();
+            outdoor.temperatureTrend = stringToTrend(data.get("temp_trend", "").asString());
+            outdoor.minTemp = compactDeci(data.get("min_temp", 0.0).asFloat());
+            outdoor.maxTemp = compactDeci(data.get("max_temp", 0.0).asFloat());
+            outdoor.minTempAge = compactMinutes(data.get("date_min_temp", 0).asUInt(), frame.timestamp);
+            outdoor.maxTempAge = compactMinutes(data.get("date_max_temp", 0).asUInt(), frame.timestamp);
+            outdoor.valid = 1;
+            HUB_LOGI("netatmo", "Outdoor: %.1f°C, %d%% RH",
+                     compactFromDeci(outdoor.temperature), outdoor.humidity);
+        } else if (type == "NAModule2" && !frame.wind.valid) {
+            CompactWind& wind = frame.wind;
+            wind.strength = data.get("WindStrength", 0).asUInt();
+            wind.angle = data.get("WindAngle", 0).asUInt();
+            wind.gustStrength = data.get("GustStrength", 0).asUInt();
+            wind.gustAngle = data.get("GustAngle", 0).asUInt();
+            wind.maxWindStrength = data.get("max_wind_str", 0).asUInt();
+            wind.maxWindAge = compactMinutes(data.get("date_max_wind_str", 0).asUInt(), frame.timestamp);
+            wind.valid = 1;
+            HUB_LOGI("netatmo", "Wind: %d km/h from %d°", wind.strength, wind.angle);
+        } else if (type == "NAModule3" && !frame.rain.valid) {
+            CompactRain& rain = frame.rain;
+            rain.current = compactDeciUnsigned(data.get("Rain", 0.0).asFloat());
+            rain.sum1h = compactDeciUnsigned(data.get("sum_rain_1", 0.0).asFloat());
+            rain.sum24h = compactDeciUnsigned(data.get("sum_rain_24", 0.0).asFloat());
+            rain.valid = 1;
+            HUB_LOGI("netatmo", "Rain: %.1fmm, 24h: %.1fmm",
+                     compactFromDeci(rain.current), compactFromDeci(rain.sum24h));
+        } else if (type == "NAModule4" && frame.roomCount < COMPACT_MAX_ROOMS) {
+            CompactRoom& room = frame.rooms[frame.roomCount++];
+            std::string name = module.get("module_name", "Raum").asString();
+            strncpy(room.name, name.c_str(), sizeof(room.name) - 1);
+            room.temperature = compactDeci(data.get("Temperature", 0.0).asFloat());
+            room.humidity = data.get("Humidity", 0).asUInt();
+            room.co2 = data.get("CO2", 0).asUInt();
+            room.temperatureTrend = stringToTrend(data.get("temp_trend", "").asString());
+            room.valid = 1;
+            HUB_LOGI("netatmo", "Room %s: %.1f°C", room.name, compactFromDeci(room.temperature));
+        }
+    }
+
+    HUB_LOGI("netatmo", "Weather data fetch complete (measured %ld)", (long)measurementTime);
+    return true;
+}
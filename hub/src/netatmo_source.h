@@ -0,0 +1,42 @@
+#ifndef HUB_NETATMO_SOURCE_H
+#define HUB_NETATMO_SOURCE_H
+
+#include <ctime>
+#include <string>
+#include <json/json.h>
+#include "hub_config.h"
+#include "http_client.h"
+
+// Netatmo station data for the hub. Mirrors NetatmoClient on the display,
+// but keeps the access token for its lifetime and persists the rotated
+// refresh token so the daemon survives restarts.
+class NetatmoSource {
+public:
+    NetatmoSource(const HubConfig& config, HttpClient& http);
+
+    // Fetch the station and fill the Netatmo part of the frame
+    bool update(CompactDashboard& frame);
+
+    // Netatmo measurement time of the last successful update
+    time_t getMeasurementTime() const { return measurementTime; }
+
+private:
+    bool ensureValidToken();
+    bool refreshAccessToken();
+    void loadRefreshToken();
+    void saveRefreshToken();
+
+    bool getJSON(const std::string& url, Json::Value& root);
+    uint8_t calculateCO2Trend(int currentCO2, time_t measured);
+
+    static uint8_t stringToTrend(const std::string& trend);
+
+    const HubConfig& config;
+    HttpClient& http;
+    std::string refreshToken;
+    std::string accessToken;
+    time_t tokenExpiry;
+    time_t measurementTime;
+};
+
+#endif  // HUB_NETATMO_SOURCE_H
@@ -0,0 +1,81 @@
+# PlatformIO extra script: packs the files in assets/ into the image of the
+# "assets" partition (partitions.csv) and flashes it.
+#
+#   pio run -t uploadassets
+#
+# Image layout (little-endian, read by src/data/assets.cpp):
+#   header   magic "ASST", uint16 version, uint16 count
+#   entries  count x {char name[48], uint32 offset, uint32 size}
+#   data     files, each 4-byte aligned; offsets from the image start
+
+Import("env")
+
+import csv
+import os
+import struct
+
+ASSET_MAGIC = 0x54535341  # "ASST"
+ASSET_VERSION = 1
+NAME_SIZE = 48
+
+project_dir = env.subst("$PROJECT_DIR")
+assets_dir = os.path.join(project_dir, "assets")
+image_path = os.path.join(env.subst("$BUILD_DIR"), "assets.bin")
+
+
+def partition(name):
+    with open(os.path.join(project_dir, "partitions.csv")) as table:
+        for row in csv.reader(line for line in table if not line.lstrip().startswith("#")):
+            row = [field.strip() for field in row]
+            if row and row[0] == name:
+                return int(row[3], 0), int(row[4], 0)
+    raise ValueError("partition %s not in partitions.csv" % name)
+
+
+def pack():
+    files = []
+    for root, _, names in sorted(os.walk(assets_dir)):
+        for name in sorted(names):
+            path = os.path.join(root, name)
+            files.append((os.path.relpath(path, assets_dir).replace(os.sep, "/"), path))
+
+    header_size = 8 + len(files) * (NAME_SIZE + 8)
+    entries = b""
+    data = b""
+    for name, path in files:
+        if len(name) >= NAME_SIZE:
+            raise ValueError("asset name too long: " + name)
+        with open(path, "rb") as f:
+            content = f.read()
+        entries += struct.pack("<%dsII" % NAME_SIZE, name.encode(), header_size + len(data), len(content))
+        data += content + b"\0" * (-len(content) % 4)
+
+    image = struct.pack("<IHH", ASSET_MAGIC, ASSET_VERSION, len(files)) + entries + data
+    _, size = partition("assets")
+    if len(image) > size:
+        raise ValueError("assets (%d bytes) exceed the partition (%d bytes)" % (len(image), size))
+
+    os.makedirs(os.path.dirname(image_path), exist_ok=True)
+    with open(image_path, "wb") as f:
+        f.write(image)
+    print("Packed %d assets into %s (%d bytes)" % (len(files), image_path, len(image)))
+
+
+def upload_assets(*args, **kwargs):
+    pack()
+    offset, _ = partition("assets")
+    env.AutodetectUploadPort()
+    env.Execute(" ".join([
+        '"$PYTHONEXE"', '"$UPLOADER"', "--chip", "esp32",
+        "--port", '"$UPLOAD_PORT"', "--baud", "$UPLOAD_SPEED",
+        "write_flash", hex(offset), '"%s"' % image_path,
+    ]))
+
+
+env.AddCustomTarget(
+    name="uploadassets",
+    dependencies=None,
+    actions=[upload_assets],
+    title="Upload assets",
+    description="Pack assets/ and flash the assets partition",
+)
@@ -3,37 +3,248 @@
 
 #include <Arduino.h>
 #include <HTTPClient.h>
+#include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
+#include <time.h>
+#include <stdarg.h>
 #include "../config.h"
+#include "../time/civil_time.h"
+
+// Number of requests whose timing is kept per wake
+#define HTTP_TIMING_SLOTS 8
+
+// "Bearer <access token>"
+#define HTTP_AUTH_HEADER_SIZE 192
+
+// Timing breakdown of a single HTTP request (durations in ms)
+struct HttpTiming {
+    char host[40];              // Target host (for logging)
+    int httpCode;               // HTTP status or negative HTTPClient error
+    uint32_t dnsMs;             // Hostname lookup
+    uint32_t connectMs;         // TCP connect + TLS handshake (WiFiClientSecure does both in connect())
+    uint32_t ttfbMs;            // Request sent until response headers parsed
+    uint32_t transferMs;        // Response body download
+    uint32_t parseMs;           // JSON deserialization
+    uint32_t bytesSent;         // Request body bytes
+    uint32_t bytesReceived;     // Response body bytes
+
+    HttpTiming() : httpCode(0), dnsMs(0), connectMs(0), ttfbMs(0), transferMs(0),
+                   parseMs(0), bytesSent(0), bytesReceived(0) {
+        host[0] = '\0';
+    }
+
+    uint32_t totalMs() const {
+        return dnsMs + connectMs + ttfbMs + transferMs + parseMs;
+    }
+};
+
+// All request timings of the current wake, in request order
+struct HttpTimingLog {
+    HttpTiming entries[HTTP_TIMING_SLOTS];
+    uint8_t count;
+
+    HttpTimingLog() : count(0) {}
+};
+
+// Receives the parsed Date header of the first response of the wake,
+// returns true if the time was accepted
+typedef bool (*ServerDateHandler)(time_t serverEpoch);
 
 class HTTPUtils {
 public:
-    // Make a GET request and parse JSON response
-    static bool httpGetJSON(const char* url, JsonDocument& doc, const char* authToken = nullptr) {
-        WiFiClientSecure client;
+    // Register a handler for the Date header of the next response that carries one.
+    // The handler is called once; every HTTPS response carries a Date header,
+    // so the clock can be disciplined without a separate NTP exchange.
+    static void setServerDateHandler(ServerDateHandler handler) {
+        serverDateHandler() = handler;
+    }
+
+    // Pass the response's Date header to the pending handler (first response only)
+    static void handleServerDate(HTTPClient& http) {
+        ServerDateHandler handler = serverDateHandler();
+        if (handler == nullptr || !http.hasHeader("Date")) {
+            return;
+        }
+
+        time_t serverEpoch = parseHTTPDate(http.header("Date").c_str());
+        if (serverEpoch == 0) {
+            return;
+        }
+
+        serverDateHandler() = nullptr;
+        handler(serverEpoch);
+    }
+
+    // Parse HTTP date header (RFC 1123, always GMT) to Unix epoch
+    static time_t parseHTTPDate(const char* dateStr) {
+        if (!dateStr || strlen(dateStr) == 0) return 0;
+
+        time_t timestamp = (time_t)CivilTime::parseRFC1123(dateStr);
+        if (timestamp == 0) {
+            ESP_LOGW("http", "Failed to parse HTTP date: %s", dateStr);
+        }
+        return timestamp;
+    }
+
+    // Timing log for this wake (lives in RAM, reset on every boot)
+    static HttpTimingLog& timingLog() {
+        static HttpTimingLog log;
+        return log;
+    }
+
+    // Timing of the most recent request
+    static HttpTiming& lastTiming() {
+        HttpTimingLog& log = timingLog();
+        return log.entries[log.count > 0 ? log.count - 1 : 0];
+    }
+
+    // Claim a timing slot for a new request (the last slot is reused when full)
+    static HttpTiming& startTiming(const char* url) {
+        HttpTimingLog& log = timingLog();
+        if (log.count < HTTP_TIMING_SLOTS) {
+            log.count++;
+        }
+        HttpTiming& timing = log.entries[log.count - 1];
+        timing = HttpTiming();
+        parseHost(url, timing.host, sizeof(timing.host), nullptr);
+        return timing;
+    }
+
+    // Log one line per request of this wake
+    static void logTimings() {
+        HttpTimingLog& log = timingLog();
+        for (uint8_t i = 0; i < log.count; i++) {
+            const HttpTiming& t = log.entries[i];
+            ESP_LOGI("http", "#%d %s [%d]: dns %lu, connect %lu, ttfb %lu, body %lu, parse %lu ms"
+                    " (total %lu ms, %lu B out, %lu B in)",
+                    i + 1, t.host, t.httpCode,
+                    (unsigned long)t.dnsMs, (unsigned long)t.connectMs, (unsigned long)t.ttfbMs,
+                    (unsigned long)t.transferMs, (unsigned long)t.parseMs, (unsigned long)t.totalMs(),
+                    (unsigned long)t.bytesSent, (unsigned long)t.bytesReceived);
+        }
+    }
+
+    // Configure client/http, resolve and connect the host, then bind the URL.
+    // DNS and connect are done explicitly so they can be timed separately;
+    // HTTPClient reuses the already connected client.
+    static bool beginRequest(WiFiClientSecure& client, HTTPClient& http,
+                             const char* url, HttpTiming& timing) {
         client.setInsecure();  // Skip certificate validation for simplicity
 
-        HTTPClient http;
         http.setReuse(false);
         http.setTimeout(HTTP_TIMEOUT_MS);
         http.setConnectTimeout(HTTP_TIMEOUT_MS);
         http.setUserAgent(HTTP_USER_AGENT);
 
+        char host[sizeof(timing.host)];
+        uint16_t port = 443;
+        if (!parseHost(url, host, sizeof(host), &port)) {
+            ESP_LOGE("http", "Invalid URL: %s", url);
+            return false;
+        }
+
+        unsigned long start = millis();
+        IPAddress ip;
+        if (!WiFi.hostByName(host, ip)) {
+            timing.dnsMs = millis() - start;
+            ESP_LOGE("http", "DNS lookup failed for: %s", host);
+            return false;
+        }
+        timing.dnsMs = millis() - start;
+
+        start = millis();
+        if (!client.connect(host, port, HTTP_TIMEOUT_MS)) {
+            timing.connectMs = millis() - start;
+            ESP_LOGE("http", "Failed to connect to: %s:%u", host, port);
+            return false;
+        }
+        timing.connectMs = millis() - start;
+
         if (!http.begin(client, url)) {
             ESP_LOGE("http", "Failed to begin HTTP connection to: %s", url);
+            client.stop();
+            return false;
+        }
+
+        // Date is needed for clock discipline (see setServerDateHandler),
+        // Expires/Last-Modified/ETag for the forecast conditional requests
+        static const char* headerKeys[] = {"Date", "Expires", "Last-Modified", "ETag"};
+        http.collectHeaders(headerKeys, 4);
+
+        return true;
+    }
+
+    // Read the response body, recording transfer time and size
+    static String readBody(HTTPClient& http, HttpTiming& timing) {
+        unsigned long start = millis();
+        String payload = http.getString();
+        timing.transferMs = millis() - start;
+        timing.bytesReceived = payload.length();
+        return payload;
+    }
+
+    // Parse the response body straight from the socket, keeping only the
+    // fields in filter (if given). The body is never held as a String, so
+    // parseMs includes the download and transferMs stays 0.
+    // Needs http.useHTTP10(true) before the request (no chunked encoding).
+    static bool parseJSONStream(HTTPClient& http, JsonDocument& doc,
+                                JsonDocument& filter, HttpTiming& timing) {
+        return parseStream(http, doc, &filter, timing);
+    }
+
+    static bool parseJSONStream(HTTPClient& http, JsonDocument& doc, HttpTiming& timing) {
+        return parseStream(http, doc, nullptr, timing);
+    }
+
+    // snprintf into a fixed buffer; false (and an error log) if truncated.
+    // Request URLs, form bodies and headers are built with this instead of
+    // String concatenation, so building a request does not touch the heap.
+    template <size_t N>
+    __attribute__((format(printf, 2, 3)))
+    static bool format(char (&buffer)[N], const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        int len = vsnprintf(buffer, N, fmt, args);
+        va_end(args);
+
+        if (len < 0 || (size_t)len >= N) {
+            ESP_LOGE("http", "Buffer too small (%d of %u bytes): %.32s", len, (unsigned)N, buffer);
+            return false;
+        }
+        return true;
+    }
+
+    // Make a GET request and parse JSON response
+    static bool httpGetJSON(const char* url, JsonDocument& doc, const char* authToken = nullptr) {
+        HttpTiming& timing = startTiming(url);
+
+        WiFiClientSecure client;
+        HTTPClient http;
+        if (!beginRequest(client, http, url, timing)) {
             return false;
         }
 
+        http.useHTTP10(true);  // Body is parsed from the socket
+
         // Add authorization header if provided
         if (authToken != nullptr) {
-            String authHeader = "Bearer ";
-            authHeader += authToken;
+            char authHeader[HTTP_AUTH_HEADER_SIZE];
+            if (!format(authHeader, "Bearer %s", authToken)) {
+                http.end();
+                return false;
+            }
             http.addHeader("Authorization", authHeader);
         }
 
         ESP_LOGI("http", "GET %s", url);
+        unsigned long start = millis();
         int httpCode = http.GET();
+        timing.ttfbMs = millis() - start;
+        timing.httpCode = httpCode;
+        if (httpCode > 0) {
+            handleServerDate(http);
+        }
 
         if (httpCode != HTTP_CODE_OK && httpCode != HTTP_CODE_MOVED_PERMANENTLY) {
             ESP_LOGE("http", "GET failed, code: %d, error: %s",
@@ -42,41 +253,38 @@ public:
             return false;
         }
 
-        String payload = http.getString();
+        bool parsed = parseJSONStream(http, doc, timing);
         http.end();
-
-        // Parse JSON response
-        DeserializationError error = deserializeJson(doc, payload);
-        if (error) {
-            ESP_LOGE("http", "JSON parse failed: %s", error.c_str());
-            ESP_LOGD("http", "Response: %s", payload.substring(0, 200).c_str());
+        if (!parsed) {
             return false;
         }
 
-        ESP_LOGI("http", "GET success, size: %d bytes", payload.length());
+        ESP_LOGI("http", "GET success, size: %lu bytes", (unsigned long)timing.bytesReceived);
         return true;
     }
 
     // Make a POST request with form data and parse JSON response
     static bool httpPostForm(const char* url, const char* formData, JsonDocument& doc) {
-        WiFiClientSecure client;
-        client.setInsecure();  // Skip certificate validation
+        HttpTiming& timing = startTiming(url);
 
+        WiFiClientSecure client;
         HTTPClient http;
-        http.setReuse(false);
-        http.setTimeout(HTTP_TIMEOUT_MS);
-        http.setConnectTimeout(HTTP_TIMEOUT_MS);
-        http.setUserAgent(HTTP_USER_AGENT);
-
-        if (!http.begin(client, url)) {
-            ESP_LOGE("http", "Failed to begin HTTP connection to: %s", url);
+        if (!beginRequest(client, http, url, timing)) {
             return false;
         }
 
+        http.useHTTP10(true);  // Body is parsed from the socket
         http.addHeader("Content-Type", "application/x-www-form-urlencoded");
 
         ESP_LOGI("http", "POST %s", url);
-        int httpCode = http.POST(formData);
+        timing.bytesSent = strlen(formData);
+        unsigned long start = millis();
+        int httpCode = http.POST((uint8_t*)formData, timing.bytesSent);
+        timing.ttfbMs = millis() - start;
+        timing.httpCode = httpCode;
+        if (httpCode > 0) {
+            handleServerDate(http);
+        }
 
         if (httpCode != HTTP_CODE_OK) {
             ESP_LOGE("http", "POST failed, code: %d, error: %s",
@@ -85,39 +293,34 @@ public:
             return false;
         }
 
-        String payload = http.getString();
+        bool parsed = parseJSONStream(http, doc, timing);
         http.end();
-
-        // Parse JSON response
-        DeserializationError error = deserializeJson(doc, payload);
-        if (error) {
-            ESP_LOGE("http", "JSON parse failed: %s", error.c_str());
-            ESP_LOGD("http", "Response: %s", payload.substring(0, 200).c_str());
+        if (!parsed) {
             return false;
         }
 
-        ESP_LOGI("http", "POST success, size: %d bytes", payload.length());
+        ESP_LOGI("http", "POST success, size: %lu bytes", (unsigned long)timing.bytesReceived);
         return true;
     }
 
     // Make a simple GET request and return the response as a string
     static bool httpGetString(const char* url, String& response) {
-        WiFiClientSecure client;
-        client.setInsecure();
+        HttpTiming& timing = startTiming(url);
 
+        WiFiClientSecure client;
         HTTPClient http;
-        http.setReuse(false);
-        http.setTimeout(HTTP_TIMEOUT_MS);
-        http.setConnectTimeout(HTTP_TIMEOUT_MS);
-        http.setUserAgent(HTTP_USER_AGENT);
-
-        if (!http.begin(client, url)) {
-            ESP_LOGE("http", "Failed to begin HTTP connection to: %s", url);
+        if (!beginRequest(client, http, url, timing)) {
             return false;
         }
 
         ESP_LOGI("http", "GET %s", url);
+        unsigned long start = millis();
         int httpCode = http.GET();
+        timing.ttfbMs = millis() - start;
+        timing.httpCode = httpCode;
+        if (httpCode > 0) {
+            handleServerDate(http);
+        }
 
         if (httpCode != HTTP_CODE_OK) {
             ESP_LOGE("http", "GET failed, code: %d", httpCode);
@@ -125,7 +328,7 @@ public:
             return false;
         }
 
-        response = http.getString();
+        response = readBody(http, timing);
         http.end();
 
         ESP_LOGI("http", "GET success, size: %d bytes", response.length());
@@ -152,6 +355,78 @@ public:
         return false;
     }
 
+private:
+    // Read-only Stream wrapper counting the bytes handed to the parser
+    struct CountingStream : public Stream {
+        Stream& inner;
+        uint32_t count;
+
+        explicit CountingStream(Stream& source) : inner(source), count(0) {}
+
+        int available() override { return inner.available(); }
+        int peek() override { return inner.peek(); }
+        int read() override {
+            int c = inner.read();
+            if (c >= 0) count++;
+            return c;
+        }
+        size_t readBytes(char* buffer, size_t length) override {
+            size_t n = inner.readBytes(buffer, length);
+            count += n;
+            return n;
+        }
+        size_t write(uint8_t) override { return 0; }
+    };
+
+    static bool parseStream(HTTPClient& http, JsonDocument& doc,
+                            JsonDocument* filter, HttpTiming& timing) {
+        WiFiClient* socket = http.getStreamPtr();
+        if (socket == nullptr) {
+            ESP_LOGE("http", "No response stream");
+            return false;
+        }
+
+        CountingStream stream(*socket);
+        unsigned long start = millis();
+        DeserializationError error = filter != nullptr
+            ? deserializeJson(doc, stream, DeserializationOption::Filter(*filter))
+            : deserializeJson(doc, stream);
+        timing.parseMs = millis() - start;
+        timing.bytesReceived = stream.count;
+
+        if (error) {
+            ESP_LOGE("http", "JSON stream parse failed: %s", error.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    static ServerDateHandler& serverDateHandler() {
+        static ServerDateHandler handler = nullptr;
+        return handler;
+    }
+
+    // Extract host (and port, if requested) from "https://host[:port]/path"
+    static bool parseHost(const char* url, char* host, size_t hostSize, uint16_t* port) {
+        const char* start = strstr(url, "://");
+        start = start ? start + 3 : url;
+
+        size_t len = strcspn(start, ":/?");
+        if (len == 0 || len >= hostSize) {
+            host[0] = '\0';
+            return false;
+        }
+        memcpy(host, start, len);
+        host[len] = '\0';
+
+        if (port != nullptr) {
+            *port = (strncmp(url, "http://", 7) == 0) ? 80 : 443;
+            if (start[len] == ':') {
+                *port = (uint16_t)atoi(start + len + 1);
+            }
+        }
+        return true;
+    }
 };
 
 #endif  // HTTP_UTILS_H
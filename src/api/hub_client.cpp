@@ -0,0 +1,112 @@
+#include "hub_client.h"
+#include "http_utils.h"
+#include "../data/crc32.h"
+#include "../data/compact_codec.h"
+
+HubClient::HubClient() : serverTime(0) {
+}
+
+bool HubClient::readExact(WiFiClient& client, uint8_t* buffer, size_t len) {
+    size_t received = 0;
+    unsigned long start = millis();
+
+    while (received < len) {
+        int available = client.available();
+        if (available > 0) {
+            int n = client.read(buffer + received, min((size_t)available, len - received));
+            if (n > 0) {
+                received += n;
+                continue;
+            }
+        }
+
+        if (!client.connected() && client.available() == 0) {
+            ESP_LOGE("hub", "Connection closed after %u of %u bytes", received, len);
+            return false;
+        }
+        if (millis() - start > HUB_TIMEOUT_MS) {
+            ESP_LOGE("hub", "Read timeout after %u of %u bytes", received, len);
+            return false;
+        }
+        delay(5);
+    }
+    return true;
+}
+
+bool HubClient::getDashboard(DashboardData& data) {
+    ESP_LOGI("hub", "Fetching dashboard from LAN hub %s:%d", HUB_HOST, HUB_PORT);
+
+    char url[64];
+    snprintf(url, sizeof(url), "tcp://%s:%d", HUB_HOST, HUB_PORT);
+    HttpTiming& timing = HTTPUtils::startTiming(url);
+
+    unsigned long start = millis();
+    IPAddress ip;
+    if (!WiFi.hostByName(HUB_HOST, ip)) {
+        ESP_LOGE("hub", "DNS lookup failed for: %s", HUB_HOST);
+        return false;
+    }
+    timing.dnsMs = millis() - start;
+
+    WiFiClient client;
+    start = millis();
+    if (!client.connect(ip, HUB_PORT, HUB_TIMEOUT_MS)) {
+        ESP_LOGE("hub", "Failed to connect to hub");
+        return false;
+    }
+    timing.connectMs = millis() - start;
+
+    HubRequest request = {};
+    request.magic = HUB_MAGIC;
+    request.version = HUB_PROTOCOL_VERSION;
+
+    start = millis();
+    client.write((const uint8_t*)&request, sizeof(request));
+    timing.bytesSent = sizeof(request);
+
+    HubFrameHeader header;
+    if (!readExact(client, (uint8_t*)&header, sizeof(header))) {
+        client.stop();
+        return false;
+    }
+    timing.ttfbMs = millis() - start;
+
+    if (header.magic != HUB_MAGIC || header.version != HUB_PROTOCOL_VERSION) {
+        ESP_LOGE("hub", "Unsupported frame (magic %08lx, version %u)",
+                (unsigned long)header.magic, header.version);
+        client.stop();
+        return false;
+    }
+
+    if (header.length != sizeof(CompactDashboard)) {
+        ESP_LOGE("hub", "Unexpected payload size %lu (expected %u)",
+                (unsigned long)header.length, sizeof(CompactDashboard));
+        client.stop();
+        return false;
+    }
+
+    CompactDashboard frame;
+    start = millis();
+    bool complete = readExact(client, (uint8_t*)&frame, sizeof(frame));
+    client.stop();
+    timing.transferMs = millis() - start;
+    if (!complete) {
+        return false;
+    }
+    timing.bytesReceived = sizeof(header) + sizeof(frame);
+    timing.httpCode = 200;
+
+    if (crc32(&frame, sizeof(frame)) != header.crc) {
+        ESP_LOGE("hub", "Frame CRC mismatch");
+        return false;
+    }
+
+    start = millis();
+    CompactCodec::unpack(frame, data);
+    timing.parseMs = millis() - start;
+    serverTime = header.serverTime;
+
+    ESP_LOGI("hub", "Frame received: %u bytes, Netatmo time %lu",
+            timing.bytesReceived, (unsigned long)frame.timestamp);
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef HUB_CLIENT_H
+#define HUB_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "../data/weather_data.h"
+#include "../data/hub_protocol.h"
+#include "../config.h"
+
+// Client for the LAN hub daemon (hub/): one plain TCP round trip returns the
+// pre-aggregated Netatmo + met.no data, replacing all HTTPS requests.
+class HubClient {
+private:
+    uint32_t serverTime;  // Hub clock from the last frame
+
+    // Read exactly len bytes or fail after HUB_TIMEOUT_MS
+    bool readExact(WiFiClient& client, uint8_t* buffer, size_t len);
+
+public:
+    HubClient();
+
+    // Fetch the dashboard frame from HUB_HOST:HUB_PORT
+    bool getDashboard(DashboardData& data);
+
+    // Hub clock (UTC epoch) of the last received frame, 0 if none
+    uint32_t getServerTime() const { return serverTime; }
+};
+
+#endif  // HUB_CLIENT_H
@@ -1,115 +1,28 @@
+#include "../config.h"
+#if FORECAST_PROVIDER == FORECAST_METNO  // Not built unless selected (providers.h)
+
 #include "meteo_client.h"
 #include "http_utils.h"
 #include <HTTPClient.h>
 #include <time.h>
 #include "../power/sleep_manager.h"
-
-// HTTP Caching (persistent across deep sleep)
-RTC_DATA_ATTR char MeteoClient::lastModified[32] = "";
-RTC_DATA_ATTR unsigned long MeteoClient::expiresTimestamp = 0;
+#include "../data/json_arena.h"
+#include "../data/cache.h"
+#include "../data/state_store.h"
+#include "../data/forecast_aggregator.h"
+#include "../time/civil_time.h"
+#include "../time/local_time.h"
 
 MeteoClient::MeteoClient() {
 }
 
-// Parse ISO8601 timestamp to Unix epoch with UTC → local time conversion
+// Parse ISO8601 timestamp ("2025-12-26T13:00:00Z") to Unix epoch
 time_t MeteoClient::parseISO8601(const char* timeStr) {
-    if (!timeStr) return 0;
-
-    struct tm tm;
-    memset(&tm, 0, sizeof(tm));
-
-    // Parse: "2025-12-26T13:00:00Z"
-    int parsed = sscanf(timeStr, "%d-%d-%dT%d:%d:%d",
-                       &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
-                       &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
-
-    if (parsed < 5) {
+    time_t epoch = (time_t)CivilTime::parseISO8601(timeStr);
+    if (epoch == 0 && timeStr) {
         ESP_LOGW("meteo", "Failed to parse timestamp: %s", timeStr);
-        return 0;
-    }
-
-    tm.tm_year -= 1900;  // Years since 1900
-    tm.tm_mon -= 1;      // Months since January
-
-    // Parse as UTC
-    setenv("TZ", "UTC", 1);
-    tzset();
-    time_t utc = mktime(&tm);
-
-    // Convert to local time (CET/CEST)
-    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
-    tzset();
-
-    return utc;
-}
-
-// Parse HTTP date header (RFC 2822) to Unix epoch
-time_t MeteoClient::parseHTTPDate(const char* dateStr) {
-    if (!dateStr || strlen(dateStr) == 0) return 0;
-
-    struct tm tm;
-    memset(&tm, 0, sizeof(tm));
-
-    // Parse: "Thu, 26 Dec 2025 14:00:00 GMT"
-    // Note: strptime may not be available on all ESP32 platforms
-    // Using manual parsing as fallback
-    char month[4];
-    int day, year, hour, min, sec;
-
-    int parsed = sscanf(dateStr, "%*s %d %3s %d %d:%d:%d",
-                       &day, month, &year, &hour, &min, &sec);
-
-    if (parsed != 6) {
-        ESP_LOGW("meteo", "Failed to parse HTTP date: %s", dateStr);
-        return 0;
     }
-
-    tm.tm_mday = day;
-    tm.tm_year = year - 1900;
-    tm.tm_hour = hour;
-    tm.tm_min = min;
-    tm.tm_sec = sec;
-
-    // Parse month
-    const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
-                           "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
-    for (int i = 0; i < 12; i++) {
-        if (strcmp(month, months[i]) == 0) {
-            tm.tm_mon = i;
-            break;
-        }
-    }
-
-    // Parse as GMT/UTC
-    setenv("TZ", "UTC", 1);
-    tzset();
-    time_t timestamp = mktime(&tm);
-
-    // Restore local timezone
-    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
-    tzset();
-
-    return timestamp;
-}
-
-// Parse met.no symbol code to enum index
-uint8_t MeteoClient::parseSymbolCode(const char* symbol) {
-    if (!symbol) return 2;  // Default: cloudy
-
-    // met.no symbol codes: clearsky, fair, partlycloudy, cloudy, rain, snow, etc.
-    // Map to our enum: 0=sunny, 1=partly_cloudy, 2=cloudy, 3=rain, 4=snow
-
-    if (strstr(symbol, "clearsky")) return 0;
-    if (strstr(symbol, "fair")) return 1;
-    if (strstr(symbol, "partlycloudy")) return 1;
-    if (strstr(symbol, "cloudy")) return 2;
-    if (strstr(symbol, "lightrain")) return 3;
-    if (strstr(symbol, "rain")) return 3;
-    if (strstr(symbol, "sleet")) return 3;  // Rain + snow mix
-    if (strstr(symbol, "snow")) return 4;
-    if (strstr(symbol, "fog")) return 2;    // Fallback to cloudy
-
-    return 2;  // Default: cloudy
+    return epoch;
 }
 
 // Legacy function kept for compatibility
@@ -121,44 +34,60 @@ void MeteoClient::parseForecastPoint(JsonObject hourly, int index, ForecastPoint
 // Main forecast fetch function
 bool MeteoClient::getForecast(ForecastData& data) {
     ESP_LOGI("meteo", "Fetching forecast from met.no");
+    ValidatorState& validators = StateStore::state().forecast;  // Persisted with the state
 
-    // 1. Check HTTP cache expiration
+    // 1. Stored series: enough while met.no's Expires has not passed, and
+    //    the base for If-Modified-Since
     time_t now = SleepManager::getEpoch();
-    if (now < expiresTimestamp && expiresTimestamp > 0) {
-        ESP_LOGI("meteo", "Cache still valid (expires in %ld sec)", expiresTimestamp - now);
-        // Use cached data - return true to skip API call
-        // Note: Actual cached data is loaded from LittleFS cache by main.cpp
-        return true;
+    bool haveSeries = DataCache::loadHourly(data.hourly);
+    if (haveSeries && now < (time_t)validators.expires && validators.expires > 0) {
+        ESP_LOGI("meteo", "Cache still valid (expires in %ld sec)", (long)(validators.expires - now));
+        if (ForecastAggregator::aggregate(data, now)) {
+            return true;
+        }
+        haveSeries = false;  // Series ends before today, fetch again
     }
 
     // 2. Build URL (max 4 decimal places for optimal caching)
-    String url = METEO_FORECAST_URL;
-    url += "?lat=";
-    url += String(LOCATION_LAT, 4);  // 46.8042
-    url += "&lon=";
-    url += String(LOCATION_LON, 4);  // 9.8565
+    char url[128];
+    if (!HTTPUtils::format(url, "%s?lat=%.4f&lon=%.4f", METEO_FORECAST_URL,
+                           (double)LOCATION_LAT, (double)LOCATION_LON)) {
+        return false;
+    }
 
-    ESP_LOGI("meteo", "URL: %s", url.c_str());
+    ESP_LOGI("meteo", "URL: %s", url);
 
     // 3. HTTP Request with caching headers
+    HttpTiming& timing = HTTPUtils::startTiming(url);
+    WiFiClientSecure client;
     HTTPClient http;
-    http.setTimeout(HTTP_TIMEOUT_MS);
-    http.begin(url);
-    http.addHeader("User-Agent", HTTP_USER_AGENT);
-
-    // Add If-Modified-Since header if we have a cached timestamp
-    if (strlen(lastModified) > 0) {
-        http.addHeader("If-Modified-Since", lastModified);
-        ESP_LOGD("meteo", "If-Modified-Since: %s", lastModified);
+    if (!HTTPUtils::beginRequest(client, http, url, timing)) {
+        return false;
+    }
+    http.useHTTP10(true);  // No chunked encoding, the body is parsed from the socket
+
+    // Conditional request only if a 304 can be answered from the stored series
+    if (haveSeries && strlen(validators.lastModified) > 0) {
+        http.addHeader("If-Modified-Since", validators.lastModified);
+        ESP_LOGD("meteo", "If-Modified-Since: %s", validators.lastModified);
     }
 
+    unsigned long requestStart = millis();
     int httpCode = http.GET();
+    timing.ttfbMs = millis() - requestStart;
+    timing.httpCode = httpCode;
+    if (httpCode > 0) {
+        HTTPUtils::handleServerDate(http);
+    }
 
     // 4. Handle HTTP status codes
     if (httpCode == 304) {
-        ESP_LOGI("meteo", "304 Not Modified - using cached data");
+        ESP_LOGI("meteo", "304 Not Modified - using stored series");
+        if (http.hasHeader("Expires")) {
+            validators.expires = HTTPUtils::parseHTTPDate(http.header("Expires").c_str());
+        }
         http.end();
-        return true;  // Data hasn't changed
+        return ForecastAggregator::aggregate(data, now);
     }
 
     if (httpCode == 429) {
@@ -179,36 +108,43 @@ bool MeteoClient::getForecast(ForecastData& data) {
         return false;
     }
 
-    // 5. Save HTTP caching headers
+    // 5. HTTP caching headers, stored only once the series is saved: a failed
+    //    parse must not turn the next request into a 304 for the old series
+    ValidatorState received = validators;
     if (http.hasHeader("Expires")) {
-        String expires = http.header("Expires");
-        expiresTimestamp = parseHTTPDate(expires.c_str());
-        ESP_LOGI("meteo", "Expires: %s (timestamp: %lu)", expires.c_str(), expiresTimestamp);
+        received.expires = HTTPUtils::parseHTTPDate(http.header("Expires").c_str());
+        ESP_LOGI("meteo", "Expires: %lu", (unsigned long)received.expires);
     }
 
     if (http.hasHeader("Last-Modified")) {
-        String lastMod = http.header("Last-Modified");
-        strncpy(lastModified, lastMod.c_str(), sizeof(lastModified) - 1);
-        lastModified[sizeof(lastModified) - 1] = '\0';
-        ESP_LOGI("meteo", "Last-Modified: %s", lastModified);
+        strncpy(received.lastModified, http.header("Last-Modified").c_str(), sizeof(received.lastModified) - 1);
+        received.lastModified[sizeof(received.lastModified) - 1] = '\0';
+        ESP_LOGI("meteo", "Last-Modified: %s", received.lastModified);
     }
 
-    // 6. Parse JSON (GeoJSON format)
-    // Read full response first to avoid stream timeout issues
-    String payload = http.getString();
-    http.end();
-
-    ESP_LOGI("meteo", "Response size: %d bytes", payload.length());
+    // 6. Parse JSON (GeoJSON format) from the socket, keeping only the
+    //    fields copied into the series below
     ESP_LOGI("meteo", "Free heap before JSON: %u", ESP.getFreeHeap());
 
-    JsonDocument doc;  // ArduinoJson v7 auto-sizing
-    DeserializationError error = deserializeJson(doc, payload);
+    JsonDocument filter(JsonArena::instance());
+    JsonObject entryFilter = filter["properties"]["timeseries"][0].to<JsonObject>();
+    entryFilter["time"] = true;
+    JsonObject instantFilter = entryFilter["data"]["instant"]["details"].to<JsonObject>();
+    instantFilter["air_temperature"] = true;
+    instantFilter["wind_speed"] = true;
+    instantFilter["wind_from_direction"] = true;
+    JsonObject next1hFilter = entryFilter["data"]["next_1_hours"].to<JsonObject>();
+    next1hFilter["details"]["precipitation_amount"] = true;
+    next1hFilter["summary"]["symbol_code"] = true;
+
+    JsonDocument doc(JsonArena::instance());  // ArduinoJson v7 auto-sizing, DOM in PSRAM
+    bool parsed = HTTPUtils::parseJSONStream(http, doc, filter, timing);
+    http.end();
 
-    // Free the payload string memory
-    payload = String();
+    ESP_LOGI("meteo", "Response size: %lu bytes", (unsigned long)timing.bytesReceived);
 
-    if (error) {
-        ESP_LOGE("meteo", "JSON parse error: %s", error.c_str());
+    if (!parsed) {
+        ESP_LOGE("meteo", "JSON parse error");
         return false;
     }
 
@@ -223,127 +159,61 @@ bool MeteoClient::getForecast(ForecastData& data) {
 
     ESP_LOGI("meteo", "Timeseries entries: %d", timeseries.size());
 
-    // 8. Get current time for day calculation
-    time_t currentTime = now;
-    struct tm* currentTm = localtime(&currentTime);
-
-    // Calculate midnight of today (local time)
-    struct tm todayMidnight = *currentTm;
-    todayMidnight.tm_hour = 0;
-    todayMidnight.tm_min = 0;
-    todayMidnight.tm_sec = 0;
-    time_t todayStart = mktime(&todayMidnight);
-
-    // 9. Aggregate 4 days of forecast data
-    for (int day = 0; day < 4; day++) {
-        time_t dayStart = todayStart + (day * 86400);  // Midnight of day
-        time_t dayEnd = dayStart + 86400;              // Midnight of next day
-
-        DailyForecast& dailyForecast = data.days[day];
-        dailyForecast.date = dayStart;
-        dailyForecast.tempMin = 127;   // Start with max values
-        dailyForecast.tempMax = -128;
-        dailyForecast.precipSum = 0;
-        dailyForecast.windSpeedMax = 0;
-        dailyForecast.windDirection = 0;
-        dailyForecast.symbolCode = 2;  // Default: cloudy
-        int hourlyIdx = 0;
-        int symbolCount[5] = {0};  // Count occurrences of each symbol type
-
-        // Iterate through timeseries
-        for (JsonObject ts : timeseries) {
-            const char* timeStr = ts["time"];
-            time_t entryTime = parseISO8601(timeStr);
-
-            // Check if this entry belongs to current day
-            if (entryTime < dayStart || entryTime >= dayEnd) continue;
-
-            // Extract instant data
-            JsonObject instant = ts["data"]["instant"]["details"];
-            if (!instant) continue;
-
-            float temp = instant["air_temperature"] | 0.0f;
-            float windMs = instant["wind_speed"] | 0.0f;
-            uint16_t windDir = instant["wind_from_direction"] | 0;
-
-            // Update min/max temperature
-            dailyForecast.tempMin = min(dailyForecast.tempMin, (int8_t)temp);
-            dailyForecast.tempMax = max(dailyForecast.tempMax, (int8_t)temp);
-
-            // Update max wind speed (convert m/s to km/h)
-            uint8_t windKmh = (uint8_t)(windMs * 3.6);
-            if (windKmh > dailyForecast.windSpeedMax) {
-                dailyForecast.windSpeedMax = windKmh;
-                dailyForecast.windDirection = windDir;
-            }
-
-            // Extract precipitation from next_1_hours (if available)
-            JsonObject next1h = ts["data"]["next_1_hours"];
-            if (next1h) {
-                float precip = next1h["details"]["precipitation_amount"] | 0.0f;
-                dailyForecast.precipSum += (uint8_t)(precip * 10);  // Store as mm*10
-
-                // Extract symbol code
-                const char* symbol = next1h["summary"]["symbol_code"];
-                if (symbol) {
-                    uint8_t code = parseSymbolCode(symbol);
-                    symbolCount[code]++;
-                }
-            }
-
-            // Collect day-time data points (3 times: 06:00, 12:00, 18:00)
-            struct tm* entryTm = localtime(&entryTime);
-            if ((entryTm->tm_hour == 6 || entryTm->tm_hour == 12 || entryTm->tm_hour == 18)
-                && hourlyIdx < 3) {
-                DayTimeForecast& dtf = dailyForecast.times[hourlyIdx];
-                dtf.hour = entryTm->tm_hour;
-                dtf.temperature = (int8_t)temp;
-
-                // Get symbol from next_1_hours
-                if (next1h) {
-                    const char* symbol = next1h["summary"]["symbol_code"];
-                    dtf.symbolCode = parseSymbolCode(symbol);
-
-                    float precip = next1h["details"]["precipitation_amount"] | 0.0f;
-                    dtf.precipitationMm = (uint8_t)(precip * 10);  // Store as mm*10
-                } else {
-                    dtf.symbolCode = 2;  // cloudy
-                    dtf.precipitationMm = 0;
-                }
-
-                hourlyIdx++;
+    // 8. Copy the timeseries into the compact series, from local midnight
+    //    up to the series horizon
+    time_t todayStart = LocalTime::startOfDay(now);
+    time_t seriesEnd = todayStart + HOURLY_SERIES_HORIZON_H * 3600;
+
+    // Parsed into a copy, so a failure leaves the stored series in place
+    HourlySeries series;
+
+    int parsedEntries = 0;
+    for (JsonObject ts : timeseries) {
+        const char* timeStr = ts["time"];
+        time_t entryTime = parseISO8601(timeStr);
+        parsedEntries++;
+
+        // Timeseries is chronological: stop at the horizon
+        if (entryTime >= seriesEnd) break;
+        if (entryTime < todayStart) continue;
+
+        JsonObject instant = ts["data"]["instant"]["details"];
+        if (!instant) continue;
+
+        float precip = 0;
+        uint8_t code = HOURLY_NO_SYMBOL;
+        JsonObject next1h = ts["data"]["next_1_hours"];
+        if (next1h) {
+            precip = next1h["details"]["precipitation_amount"] | 0.0f;
+            const char* symbol = next1h["summary"]["symbol_code"];
+            if (symbol) {
+                code = MetnoSymbols::parse(symbol);
             }
         }
 
-        // Determine dominant symbol for the day (most frequent)
-        uint8_t maxCount = 0;
-        uint8_t dominantSymbol = 2;  // Default: cloudy
-        for (int i = 0; i < 5; i++) {
-            if (symbolCount[i] > maxCount) {
-                maxCount = symbolCount[i];
-                dominantSymbol = i;
-            }
-        }
-        dailyForecast.symbolCode = dominantSymbol;
-
-        // Validate data
-        dailyForecast.valid = (dailyForecast.tempMin < 127 && dailyForecast.tempMax > -128);
-
-        if (dailyForecast.valid) {
-            ESP_LOGI("meteo", "Day %d: %d/%d°C, precip: %dmm, wind: %dkm/h, symbol: %d, hours: %d",
-                    day, dailyForecast.tempMin, dailyForecast.tempMax,
-                    dailyForecast.precipSum / 10, dailyForecast.windSpeedMax,
-                    dailyForecast.symbolCode, hourlyIdx);
-        } else {
-            ESP_LOGW("meteo", "Day %d: No valid data", day);
+        if (!series.append(entryTime, instant["air_temperature"] | 0.0f, precip,
+                           instant["wind_speed"] | 0.0f, instant["wind_from_direction"] | 0, code)) {
+            break;  // Full
         }
     }
 
-    // 10. Fill current forecast (for backward compatibility)
-    if (data.days[0].valid && data.days[0].times[0].temperature != 0) {
-        data.current.temperature = data.days[0].times[0].temperature;
-        data.current.weatherCode = data.days[0].symbolCode;
-        data.current.valid = true;
+    ESP_LOGD("meteo", "Parsed %d of %d timeseries entries, kept %u",
+             parsedEntries, timeseries.size(), series.count);
+
+    if (series.count == 0) {
+        ESP_LOGE("meteo", "No usable timeseries entries");
+        return false;
+    }
+
+    // Validators only for a stored series (a failed write removes the file)
+    data.hourly = series;
+    if (DataCache::saveHourly(series)) {
+        validators = received;
+    }
+
+    if (!ForecastAggregator::aggregate(data, now)) {
+        ESP_LOGE("meteo", "No forecast data for today");
+        return false;
     }
 
     ESP_LOGI("meteo", "Forecast parsed successfully");
@@ -375,3 +245,5 @@ const char* MeteoClient::getWeatherIcon(uint8_t code) {
     if (code >= 71 && code <= 77) return "snow";
     return "cloudy";
 }
+
+#endif  // FORECAST_PROVIDER == FORECAST_METNO
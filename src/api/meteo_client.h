@@ -4,23 +4,14 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "../data/weather_data.h"
+#include "weather_provider.h"
 #include "../config.h"
 
-class MeteoClient {
+class MeteoClient : public ForecastProvider<MeteoClient> {
 private:
-    // HTTP caching (persistent across deep sleep via RTC_DATA_ATTR in .cpp)
-    static char lastModified[32];
-    static unsigned long expiresTimestamp;
-
-    // Parse ISO8601 timestamp to Unix epoch (UTC → local time)
+    // Parse ISO8601 UTC timestamp to Unix epoch
     time_t parseISO8601(const char* timeStr);
 
-    // Parse HTTP date header (RFC 2822) to Unix epoch
-    time_t parseHTTPDate(const char* dateStr);
-
-    // Parse met.no symbol code to enum index
-    uint8_t parseSymbolCode(const char* symbol);
-
     // Legacy: Parse a forecast point from JSON (deprecated, kept for compatibility)
     void parseForecastPoint(JsonObject hourly, int index, ForecastPoint& point);
 
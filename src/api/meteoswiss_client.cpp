@@ -0,0 +1,207 @@
+#include "../config.h"
+#if FORECAST_PROVIDER == FORECAST_METEOSWISS  // Not built unless selected (providers.h)
+
+#include "meteoswiss_client.h"
+#include "http_utils.h"
+#include <HTTPClient.h>
+#include <time.h>
+#include "../power/sleep_manager.h"
+#include "../data/json_arena.h"
+#include "../data/cache.h"
+#include "../data/state_store.h"
+#include "../data/forecast_aggregator.h"
+#include "../time/local_time.h"
+
+// Keep hourly points this many hours after local midnight, then every 3rd
+// hour (the 3-hourly icon/wind resolution) up to HOURLY_SERIES_HORIZON_H
+#define METEOSWISS_HOURLY_SPAN_H 60
+
+MeteoSwissClient::MeteoSwissClient() {
+}
+
+static void copyHeader(HTTPClient& http, const char* name, char* dest, size_t size) {
+    if (!http.hasHeader(name)) {
+        dest[0] = '\0';
+        return;
+    }
+    strncpy(dest, http.header(name).c_str(), size - 1);
+    dest[size - 1] = '\0';
+}
+
+// Expires of a 200/304 response: the stored series is current until then
+static void copyExpires(HTTPClient& http, ValidatorState& validators) {
+    if (http.hasHeader("Expires")) {
+        validators.expires = HTTPUtils::parseHTTPDate(http.header("Expires").c_str());
+    }
+}
+
+bool MeteoSwissClient::getForecast(ForecastData& data) {
+    ESP_LOGI("meteoswiss", "Fetching forecast from MeteoSwiss");
+    ValidatorState& validators = StateStore::state().forecast;  // Persisted with the state
+
+    // 1. Stored series: base for the conditional request
+    time_t now = SleepManager::getEpoch();
+    bool haveSeries = DataCache::loadHourly(data.hourly);
+    if (haveSeries && now < (time_t)validators.expires && validators.expires > 0) {
+        ESP_LOGI("meteoswiss", "Cache still valid (expires in %ld sec)", (long)(validators.expires - now));
+        if (ForecastAggregator::aggregate(data, now)) {
+            return true;
+        }
+        haveSeries = false;  // Series ends before today, fetch again
+    }
+
+    char url[96];
+    if (!HTTPUtils::format(url, "%s?plz=%lu", METEOSWISS_FORECAST_URL, (unsigned long)METEOSWISS_POINT_ID)) {
+        return false;
+    }
+    ESP_LOGI("meteoswiss", "URL: %s", url);
+
+    // 2. HTTP request, conditional only if a 304 can be answered from the series
+    HttpTiming& timing = HTTPUtils::startTiming(url);
+    WiFiClientSecure client;
+    HTTPClient http;
+    if (!HTTPUtils::beginRequest(client, http, url, timing)) {
+        return false;
+    }
+    http.useHTTP10(true);  // No chunked encoding, the body is parsed from the socket
+
+    if (haveSeries && validators.etag[0] != '\0') {
+        http.addHeader("If-None-Match", validators.etag);
+    }
+    if (haveSeries && validators.lastModified[0] != '\0') {
+        http.addHeader("If-Modified-Since", validators.lastModified);
+    }
+
+    unsigned long requestStart = millis();
+    int httpCode = http.GET();
+    timing.ttfbMs = millis() - requestStart;
+    timing.httpCode = httpCode;
+    if (httpCode > 0) {
+        HTTPUtils::handleServerDate(http);
+    }
+
+    // 3. Handle HTTP status codes
+    if (httpCode == 304) {
+        ESP_LOGI("meteoswiss", "304 Not Modified - using stored series");
+        copyExpires(http, validators);
+        http.end();
+        return ForecastAggregator::aggregate(data, now);
+    }
+
+    if (httpCode != 200) {
+        ESP_LOGE("meteoswiss", "HTTP error: %d", httpCode);
+        http.end();
+        return false;
+    }
+
+    // Validators of this response, stored only once its series is saved:
+    // a failed parse must not turn the next request into a 304 for the old series
+    ValidatorState received = validators;
+    copyExpires(http, received);
+    copyHeader(http, "ETag", received.etag, sizeof(received.etag));
+    copyHeader(http, "Last-Modified", received.lastModified, sizeof(received.lastModified));
+
+    // 4. Stream-parse only the graph arrays (the full response also carries
+    //    warnings, 7-day summaries and 10-minute temperature/wind series)
+    JsonDocument filter(JsonArena::instance());
+    JsonObject graphFilter = filter["graph"].to<JsonObject>();
+    graphFilter["start"] = true;
+    graphFilter["startLowResolution"] = true;
+    graphFilter["temperatureMean1h"] = true;
+    graphFilter["precipitation10m"] = true;
+    graphFilter["precipitation1h"] = true;
+    graphFilter["weatherIcon3h"] = true;
+    graphFilter["windSpeed3h"] = true;
+    graphFilter["windDirection3h"] = true;
+
+    JsonDocument doc(JsonArena::instance());
+    bool parsed = HTTPUtils::parseJSONStream(http, doc, filter, timing);
+    http.end();
+
+    ESP_LOGI("meteoswiss", "Payload %lu B, download + parse %lu ms",
+             (unsigned long)timing.bytesReceived, (unsigned long)timing.parseMs);
+
+    if (!parsed) {
+        return false;
+    }
+
+    // Parsed into a copy, so a failure leaves the stored series in place
+    HourlySeries series;
+    if (!parseGraph(doc["graph"], now, series)) {
+        ESP_LOGE("meteoswiss", "No graph data in response");
+        return false;
+    }
+
+    // Validators only for a stored series (a failed write removes the file)
+    data.hourly = series;
+    if (DataCache::saveHourly(series)) {
+        validators = received;
+    }
+
+    if (!ForecastAggregator::aggregate(data, now)) {
+        ESP_LOGE("meteoswiss", "No forecast data for today");
+        return false;
+    }
+
+    ESP_LOGI("meteoswiss", "Forecast parsed successfully");
+    return true;
+}
+
+bool MeteoSwissClient::parseGraph(JsonObject graph, time_t now, HourlySeries& series) {
+    JsonArray temperature = graph["temperatureMean1h"];
+    if (!graph || !temperature) {
+        return false;
+    }
+
+    JsonArray precip10m = graph["precipitation10m"];
+    JsonArray precip1h = graph["precipitation1h"];
+    JsonArray icons = graph["weatherIcon3h"];
+    JsonArray windSpeed = graph["windSpeed3h"];
+    JsonArray windDirection = graph["windDirection3h"];
+
+    // Timestamps are epoch milliseconds; precipitation10m covers start until
+    // startLowResolution, precipitation1h continues from there
+    time_t start = (time_t)((graph["start"] | 0.0) / 1000);
+    time_t lowResStart = (time_t)((graph["startLowResolution"] | 0.0) / 1000);
+    int lowResHour = lowResStart > start ? (int)((lowResStart - start) / 3600) : 0;
+
+    time_t todayStart = LocalTime::startOfDay(now);
+    time_t hourlyEnd = todayStart + METEOSWISS_HOURLY_SPAN_H * 3600;
+    time_t seriesEnd = todayStart + HOURLY_SERIES_HORIZON_H * 3600;
+
+    series.clear();
+
+    int hours = temperature.size();
+    for (int h = 0; h < hours; h++) {
+        time_t entryTime = start + (time_t)h * 3600;
+        if (entryTime >= seriesEnd) break;
+        if (entryTime < todayStart) continue;
+        if (entryTime >= hourlyEnd && ((entryTime - todayStart) / 3600) % 3 != 0) continue;
+
+        // Precipitation of the following hour
+        float precip = 0;
+        if (h >= lowResHour) {
+            precip = precip1h[h - lowResHour] | 0.0f;
+        } else {
+            for (int i = h * 6; i < h * 6 + 6; i++) {
+                precip += precip10m[i] | 0.0f;
+            }
+        }
+
+        int slot = h / 3;
+        uint8_t code = HOURLY_NO_SYMBOL;
+        if (!icons[slot].isNull()) {
+            code = parseMeteoSwissPictogram(icons[slot] | 0);
+        }
+
+        if (!series.append(entryTime, temperature[h] | 0.0f, precip,
+                           (windSpeed[slot] | 0.0f) / 3.6f, windDirection[slot] | 0, code)) {
+            break;  // Full
+        }
+    }
+
+    ESP_LOGD("meteoswiss", "Kept %u of %d hourly points", series.count, hours);
+    return series.count > 0;
+}
+
+#endif  // FORECAST_PROVIDER == FORECAST_METEOSWISS
@@ -0,0 +1,25 @@
+#ifndef METEOSWISS_CLIENT_H
+#define METEOSWISS_CLIENT_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../data/weather_data.h"
+#include "weather_provider.h"
+#include "../config.h"
+
+// MeteoSwiss app forecast (plzDetail) for METEOSWISS_POINT_ID. Same interface
+// as MeteoClient (ForecastProvider): fills data.hourly and aggregates it with ForecastAggregator.
+class MeteoSwissClient : public ForecastProvider<MeteoSwissClient> {
+private:
+    // Copy the filtered "graph" block into the series, from local midnight
+    // up to the series horizon
+    bool parseGraph(JsonObject graph, time_t now, HourlySeries& series);
+
+public:
+    MeteoSwissClient();
+
+    // Get the forecast from the MeteoSwiss app API
+    bool getForecast(ForecastData& data);
+};
+
+#endif  // METEOSWISS_CLIENT_H
@@ -1,25 +1,34 @@
+#include "../config.h"
+#if CONDITIONS_PROVIDER == CONDITIONS_NETATMO  // Not built unless selected (providers.h)
+
 #include "netatmo_client.h"
 #include "http_utils.h"
 #include <time.h>
+#include "../data/json_arena.h"
+#include "../data/crc32.h"
+#include "../data/history_log.h"
+#include "../power/sleep_manager.h"
 
-NetatmoClient::NetatmoClient() : accessToken(""), tokenExpiry(0) {
+NetatmoClient::NetatmoClient() {
 }
 
 bool NetatmoClient::refreshAccessToken() {
     ESP_LOGI("netatmo", "Refreshing OAuth2 access token");
 
+    // Netatmo rotates the refresh token; use the latest one we were given
+    TokenState& state = tokens();
+    const char* refreshToken = state.refreshToken[0] != '\0' ? state.refreshToken : NETATMO_REFRESH_TOKEN;
+
     // Build form data for token refresh
-    String formData = "grant_type=refresh_token";
-    formData += "&refresh_token=";
-    formData += NETATMO_REFRESH_TOKEN;
-    formData += "&client_id=";
-    formData += NETATMO_CLIENT_ID;
-    formData += "&client_secret=";
-    formData += NETATMO_CLIENT_SECRET;
+    char formData[384];
+    if (!HTTPUtils::format(formData, "grant_type=refresh_token&refresh_token=%s&client_id=%s&client_secret=%s",
+                           refreshToken, NETATMO_CLIENT_ID, NETATMO_CLIENT_SECRET)) {
+        return false;
+    }
 
     // Make POST request to token endpoint
-    JsonDocument doc;
-    if (!HTTPUtils::httpPostForm(NETATMO_TOKEN_URL, formData.c_str(), doc)) {
+    JsonDocument doc(JsonArena::instance());
+    if (!HTTPUtils::httpPostForm(NETATMO_TOKEN_URL, formData, doc)) {
         ESP_LOGE("netatmo", "Token refresh failed");
         return false;
     }
@@ -30,17 +39,42 @@ bool NetatmoClient::refreshAccessToken() {
         return false;
     }
 
-    accessToken = doc["access_token"].as<String>();
+    const char* token = doc["access_token"];
+    if (strlen(token) >= sizeof(state.accessToken)) {
+        ESP_LOGE("netatmo", "access_token too long (%u characters)", (unsigned)strlen(token));
+        return false;
+    }
+    strcpy(state.accessToken, token);
     int expiresIn = doc["expires_in"] | 10800;  // Default 3 hours
-    tokenExpiry = millis() + (expiresIn * 1000);
+    state.accessExpiry = (uint32_t)SleepManager::getEpoch() + expiresIn;
 
     ESP_LOGI("netatmo", "Token refreshed, expires in %d seconds", expiresIn);
+
+    // The previous refresh token stops working once the new one is issued:
+    // persist the rotation right away instead of at the end of the wake
+    const char* rotated = doc["refresh_token"] | "";
+    if (rotated[0] != '\0' && strcmp(rotated, refreshToken) != 0 &&
+        strlen(rotated) < sizeof(state.refreshToken)) {
+        strcpy(state.refreshToken, rotated);
+        ESP_LOGI("netatmo", "Refresh token rotated");
+        StateStore::commit();
+    }
     return true;
 }
 
 bool NetatmoClient::ensureValidToken() {
+    // Stored tokens belong to the configured refresh token; a new one in
+    // config.h (re-authorization) invalidates them
+    TokenState& state = tokens();
+    uint32_t configHash = crc32(NETATMO_REFRESH_TOKEN, strlen(NETATMO_REFRESH_TOKEN));
+    if (state.configHash != configHash) {
+        memset(&state, 0, sizeof(state));
+        state.configHash = configHash;
+    }
+
     // Check if token is still valid (with 60s buffer)
-    if (accessToken.length() > 0 && millis() < (tokenExpiry - 60000)) {
+    time_t now = SleepManager::getEpoch();
+    if (state.accessToken[0] != '\0' && now + 60 < (time_t)state.accessExpiry) {
         return true;
     }
 
@@ -163,14 +197,41 @@ void NetatmoClient::parseRainData(JsonObject module, RainData& rain) {
             rain.current, rain.sum1h, rain.sum24h);
 }
 
-JsonObject NetatmoClient::findModuleByType(JsonArray modules, const char* type) {
-    for (JsonObject module : modules) {
-        const char* moduleType = module["type"];
-        if (moduleType && strcmp(moduleType, type) == 0) {
-            return module;
-        }
+void NetatmoClient::parseRoomData(JsonObject dashboard, const char* name, RoomData& room) {
+    strncpy(room.name, name, sizeof(room.name) - 1);
+    room.name[sizeof(room.name) - 1] = '\0';
+
+    room.temperature = dashboard["Temperature"] | 0.0f;
+    room.humidity = dashboard["Humidity"] | 0;
+    room.co2 = dashboard["CO2"] | 0;
+    room.temperatureTrend = stringToTrend(dashboard["temp_trend"] | "unknown");
+    room.valid = true;
+
+    ESP_LOGI("netatmo", "Room %s: %.1f°C, %d%% RH, %d ppm CO2",
+            room.name, room.temperature, room.humidity, room.co2);
+}
+
+NetatmoClient::ModuleSlot NetatmoClient::slotForType(const char* type) {
+    // "NAModule1".."NAModule4": the prefix and one digit decide the slot
+    if (!type || strncmp(type, "NAModule", 8) != 0 || type[9] != '\0') {
+        return SLOT_NONE;
+    }
+    switch (type[8]) {
+        case '1': return SLOT_OUTDOOR;
+        case '2': return SLOT_WIND;
+        case '3': return SLOT_RAIN;
+        case '4': return SLOT_ROOM;
+        default: return SLOT_NONE;
     }
-    return JsonObject();
+}
+
+void NetatmoClient::addRoom(WeatherData& data, JsonObject dashboard, const char* name) {
+    if (!dashboard) return;
+    if (data.roomCount >= MAX_ROOMS) {
+        ESP_LOGW("netatmo", "More than %d rooms, ignoring %s", MAX_ROOMS, name);
+        return;
+    }
+    parseRoomData(dashboard, name, data.rooms[data.roomCount++]);
 }
 
 bool NetatmoClient::getWeatherData(WeatherData& data) {
@@ -182,15 +243,15 @@ bool NetatmoClient::getWeatherData(WeatherData& data) {
         return false;
     }
 
-    // Build URL with device ID parameter
-    String url = NETATMO_WEATHER_URL;
-    url += "?device_id=";
-    url += NETATMO_DEVICE_ID;
+    // Build URL (without device ID all stations of the account are returned)
+    const char* url = NETATMO_ALL_STATIONS ? NETATMO_WEATHER_URL
+                                           : NETATMO_WEATHER_URL "?device_id=" NETATMO_DEVICE_ID;
 
     // Make API request
-    JsonDocument doc;
-    if (!HTTPUtils::httpGetJSONWithRetry(url.c_str(), doc, accessToken.c_str())) {
+    JsonDocument doc(JsonArena::instance());
+    if (!HTTPUtils::httpGetJSONWithRetry(url, doc, tokens().accessToken)) {
         ESP_LOGE("netatmo", "Failed to fetch weather data");
+        tokens().accessExpiry = 0;  // Token may have been revoked: refresh on the next wake
         return false;
     }
 
@@ -202,48 +263,76 @@ bool NetatmoClient::getWeatherData(WeatherData& data) {
     }
 
     JsonArray devices = body["devices"];
-    if (!devices || devices.size() == 0) {
+    if (!devices) {
         ESP_LOGE("netatmo", "No devices in response");
         return false;
     }
 
-    JsonObject device = devices[0];
-
-    // Get station name
-    data.stationName = device["station_name"] | "Unknown";
-
-    // Get last measurement timestamp
-    JsonObject dashboard = device["dashboard_data"];
-    if (dashboard) {
-        data.timestamp = dashboard["time_utc"] | 0;
-    }
-
-    // Parse indoor data (main device)
-    parseIndoorData(device, data.indoor);
-
-    // Get modules array
-    JsonArray modules = device["modules"];
-    if (modules) {
-        // Find and parse outdoor module (NAModule1)
-        JsonObject outdoorModule = findModuleByType(modules, "NAModule1");
-        if (!outdoorModule.isNull()) {
-            parseOutdoorData(outdoorModule, data.outdoor);
+    // One pass over all stations and their modules, each sent to its slot.
+    // The main station is NETATMO_DEVICE_ID; until it shows up the first
+    // station fills the main slots, and becomes a room if it is listed later.
+    data.roomCount = 0;
+    data.stationCount = 0;
+    bool primaryFound = false;
+    JsonObject firstStation;
+    for (JsonObject device : devices) {
+        const char* id = device["_id"];
+        bool isPrimary = false;
+        if (!primaryFound && id && strcmp(id, NETATMO_DEVICE_ID) == 0) {
+            if (data.stationCount > 0) {
+                ESP_LOGI("netatmo", "Main station listed after %u others", data.stationCount);
+                data.indoor = IndoorData();
+                data.outdoor = OutdoorData();
+                data.wind = WindData();
+                data.rain = RainData();
+                data.timestamp = 0;
+                addRoom(data, firstStation["dashboard_data"].as<JsonObject>(),
+                        firstStation["station_name"] | "Unknown");
+            }
+            primaryFound = true;
+            isPrimary = true;
+        } else if (data.stationCount == 0) {
+            firstStation = device;
+            isPrimary = true;
         }
-
-        // Find and parse wind module (NAModule2)
-        JsonObject windModule = findModuleByType(modules, "NAModule2");
-        if (!windModule.isNull()) {
-            parseWindData(windModule, data.wind);
+        data.stationCount++;
+
+        JsonObject dashboard = device["dashboard_data"];
+        const char* stationName = device["station_name"] | "Unknown";
+
+        if (isPrimary) {
+            data.stationName = stationName;
+            if (dashboard) {
+                data.timestamp = dashboard["time_utc"] | 0;
+            }
+            parseIndoorData(device, data.indoor);
+        } else {
+            addRoom(data, dashboard, stationName);
         }
 
-        // Find and parse rain module (NAModule3)
-        JsonObject rainModule = findModuleByType(modules, "NAModule3");
-        if (!rainModule.isNull()) {
-            parseRainData(rainModule, data.rain);
+        for (JsonObject module : device["modules"].as<JsonArray>()) {
+            ModuleSlot slot = slotForType(module["type"].as<const char*>());
+            if (slot == SLOT_ROOM) {
+                addRoom(data, module["dashboard_data"].as<JsonObject>(), module["module_name"] | "Raum");
+            } else if (!isPrimary) {
+                continue;  // Outdoor modules of other stations are not shown
+            } else if (slot == SLOT_OUTDOOR && !data.outdoor.valid) {
+                parseOutdoorData(module, data.outdoor);
+            } else if (slot == SLOT_WIND && !data.wind.valid) {
+                parseWindData(module, data.wind);
+            } else if (slot == SLOT_RAIN && !data.rain.valid) {
+                parseRainData(module, data.rain);
+            }
         }
     }
 
-    ESP_LOGI("netatmo", "Weather data fetch complete");
+    if (data.stationCount == 0) {
+        ESP_LOGE("netatmo", "No devices in response");
+        return false;
+    }
+
+    ESP_LOGI("netatmo", "Weather data fetch complete (%u stations, %u rooms)",
+            data.stationCount, data.roomCount);
     return true;
 }
 
@@ -256,14 +345,9 @@ unsigned long NetatmoClient::getLastUpdateTime() {
         return 0;
     }
 
-    // Build URL
-    String url = NETATMO_WEATHER_URL;
-    url += "?device_id=";
-    url += NETATMO_DEVICE_ID;
-
     // Make API request
-    JsonDocument doc;
-    if (!HTTPUtils::httpGetJSON(url.c_str(), doc, accessToken.c_str())) {
+    JsonDocument doc(JsonArena::instance());
+    if (!HTTPUtils::httpGetJSON(NETATMO_WEATHER_URL "?device_id=" NETATMO_DEVICE_ID, doc, tokens().accessToken)) {
         ESP_LOGE("netatmo", "Failed to fetch last update time");
         return 0;
     }
@@ -294,27 +378,58 @@ unsigned long NetatmoClient::getLastUpdateTime() {
 Trend NetatmoClient::calculateCO2Trend(int currentCO2) {
     ESP_LOGI("netatmo", "Calculating CO2 trend (current: %d ppm)", currentCO2);
 
-    // Build URL for getmeasure API
-    // Get CO2 measurement from 10 minutes ago (previous Netatmo measurement)
+    // CO2 measurement from 10 minutes ago (previous Netatmo measurement),
+    // looked up in a 10 minute window around that time
     time_t now = time(nullptr);
     time_t tenMinutesAgo = now - 600;  // 10 minutes = 600 seconds
 
-    String url = "https://api.netatmo.com/api/getmeasure";
-    url += "?device_id=";
-    url += NETATMO_DEVICE_ID;
-    url += "&scale=max";  // Get max value in the time range
-    url += "&type=CO2";
-    url += "&date_begin=";
-    url += String(tenMinutesAgo - 300);  // 5 minute window before
-    url += "&date_end=";
-    url += String(tenMinutesAgo + 300);  // 5 minute window after (total 10 min window)
-    url += "&limit=1";  // Only need one measurement
+    // The previous wake's reading is usually in the local history
+    int previousCO2 = 0;
+    HistoryRecord recent[4];
+    size_t found = History::queryRaw(tenMinutesAgo - 300, tenMinutesAgo + 300, recent, 4);
+    for (size_t i = found; i > 0 && previousCO2 == 0; i--) {
+        previousCO2 = recent[i - 1].co2;
+    }
+
+    if (previousCO2 > 0) {
+        ESP_LOGI("netatmo", "Previous CO2 from local history");
+    } else {
+        previousCO2 = fetchPreviousCO2(tenMinutesAgo - 300, tenMinutesAgo + 300);
+        if (previousCO2 <= 0) {
+            return Trend::STABLE;
+        }
+    }
+
+    // Calculate trend based on difference
+    // Threshold: >30 ppm change over 10 minutes is significant for CO2
+    int diff = currentCO2 - previousCO2;
+
+    ESP_LOGI("netatmo", "CO2 trend: current %d ppm, 10min ago %d ppm, diff %+d ppm",
+            currentCO2, previousCO2, diff);
+
+    if (diff > 30) {
+        return Trend::UP;
+    } else if (diff < -30) {
+        return Trend::DOWN;
+    } else {
+        return Trend::STABLE;
+    }
+}
+
+int NetatmoClient::fetchPreviousCO2(time_t from, time_t to) {
+    // Max value in the window, one measurement only
+    char url[160];
+    if (!HTTPUtils::format(url, NETATMO_MEASURE_URL "?device_id=%s&scale=max&type=CO2"
+                           "&date_begin=%ld&date_end=%ld&limit=1",
+                           NETATMO_DEVICE_ID, (long)from, (long)to)) {
+        return 0;
+    }
 
     // Make API request
-    JsonDocument doc;
-    if (!HTTPUtils::httpGetJSONWithRetry(url.c_str(), doc, accessToken.c_str())) {
+    JsonDocument doc(JsonArena::instance());
+    if (!HTTPUtils::httpGetJSONWithRetry(url, doc, tokens().accessToken)) {
         ESP_LOGW("netatmo", "Failed to fetch historical CO2 data, defaulting to STABLE");
-        return Trend::STABLE;
+        return 0;
     }
 
     // Parse response
@@ -322,36 +437,23 @@ Trend NetatmoClient::calculateCO2Trend(int currentCO2) {
     JsonArray body = doc["body"];
     if (!body || body.size() == 0) {
         ESP_LOGW("netatmo", "No historical CO2 data in response, defaulting to STABLE");
-        return Trend::STABLE;
+        return 0;
     }
 
     JsonObject measurement = body[0];
     JsonArray values = measurement["value"];
     if (!values || values.size() == 0) {
         ESP_LOGW("netatmo", "No CO2 values in measurement, defaulting to STABLE");
-        return Trend::STABLE;
+        return 0;
     }
 
     JsonArray co2Array = values[0];
     if (!co2Array || co2Array.size() == 0) {
         ESP_LOGW("netatmo", "Empty CO2 array, defaulting to STABLE");
-        return Trend::STABLE;
+        return 0;
     }
 
-    int previousCO2 = co2Array[0] | 0;
-
-    // Calculate trend based on difference
-    // Threshold: >30 ppm change over 10 minutes is significant for CO2
-    int diff = currentCO2 - previousCO2;
-
-    ESP_LOGI("netatmo", "CO2 trend: current %d ppm, 10min ago %d ppm, diff %+d ppm",
-            currentCO2, previousCO2, diff);
-
-    if (diff > 30) {
-        return Trend::UP;
-    } else if (diff < -30) {
-        return Trend::DOWN;
-    } else {
-        return Trend::STABLE;
-    }
+    return co2Array[0] | 0;
 }
+
+#endif  // CONDITIONS_PROVIDER == CONDITIONS_NETATMO
@@ -4,12 +4,15 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "../data/weather_data.h"
+#include "weather_provider.h"
+#include "../data/state_store.h"
 #include "../config.h"
 
-class NetatmoClient {
+class NetatmoClient : public ConditionsProvider<NetatmoClient> {
 private:
-    String accessToken;
-    unsigned long tokenExpiry;  // millis() when token expires
+    // Access token, expiry and rotated refresh token live in the state store,
+    // so a wake within the token lifetime skips the refresh request
+    static TokenState& tokens() { return StateStore::state().tokens; }
 
     // Refresh the OAuth2 access token using the refresh token
     bool refreshAccessToken();
@@ -29,8 +32,15 @@ private:
     // Parse rain module data from JSON
     void parseRainData(JsonObject module, RainData& rain);
 
-    // Find a module by type in the modules array
-    JsonObject findModuleByType(JsonArray modules, const char* type);
+    // Parse an extra room (NAModule4 or another station's base unit)
+    void parseRoomData(JsonObject dashboard, const char* name, RoomData& room);
+
+    // Append a room if there is space left
+    void addRoom(WeatherData& data, JsonObject dashboard, const char* name);
+
+    // Where a module's data goes, from its "type"
+    enum ModuleSlot { SLOT_NONE, SLOT_OUTDOOR, SLOT_WIND, SLOT_RAIN, SLOT_ROOM };
+    static ModuleSlot slotForType(const char* type);
 
 public:
     NetatmoClient();
@@ -43,6 +53,9 @@ public:
 
     // Calculate CO2 trend from historical data (comparing current to 10 minutes ago)
     Trend calculateCO2Trend(int currentCO2);
+
+    // CO2 maximum in [from, to] from the getmeasure API, 0 if unavailable
+    int fetchPreviousCO2(time_t from, time_t to);
 };
 
 #endif  // NETATMO_CLIENT_H
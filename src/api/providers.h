@@ -0,0 +1,34 @@
+#ifndef PROVIDERS_H
+#define PROVIDERS_H
+
+#include <type_traits>
+#include "weather_provider.h"
+#include "../config.h"
+
+// Provider selection (CONDITIONS_PROVIDER / FORECAST_PROVIDER in config.h).
+// Only the selected sources are included here, and the others' .cpp files
+// compile to nothing, so unused providers are neither built nor linked.
+
+#if CONDITIONS_PROVIDER == CONDITIONS_NETATMO
+#include "netatmo_client.h"
+typedef NetatmoClient ConditionsSource;
+#else
+#error "Unknown CONDITIONS_PROVIDER"
+#endif
+
+#if FORECAST_PROVIDER == FORECAST_METNO
+#include "meteo_client.h"
+typedef MeteoClient ForecastSource;
+#elif FORECAST_PROVIDER == FORECAST_METEOSWISS
+#include "meteoswiss_client.h"
+typedef MeteoSwissClient ForecastSource;
+#else
+#error "Unknown FORECAST_PROVIDER"
+#endif
+
+static_assert(std::is_base_of<ConditionsProvider<ConditionsSource>, ConditionsSource>::value,
+              "Conditions source must derive from ConditionsProvider");
+static_assert(std::is_base_of<ForecastProvider<ForecastSource>, ForecastSource>::value,
+              "Forecast source must derive from ForecastProvider");
+
+#endif  // PROVIDERS_H
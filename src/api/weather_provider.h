@@ -0,0 +1,35 @@
+#ifndef WEATHER_PROVIDER_H
+#define WEATHER_PROVIDER_H
+
+#include "../data/weather_data.h"
+
+// Compile-time provider interface (CRTP). A source derives from the base for
+// its role and implements the named method; calls resolve statically, so
+// there is no vtable and no indirect call on the wake path. The concrete
+// sources are picked in providers.h from config.h.
+
+// Current conditions: Derived::getWeatherData(WeatherData&)
+template <class Derived>
+class ConditionsProvider {
+public:
+    bool fetchConditions(WeatherData& data) {
+        return static_cast<Derived*>(this)->getWeatherData(data);
+    }
+
+protected:
+    ConditionsProvider() {}
+};
+
+// Forecast: Derived::getForecast(ForecastData&)
+template <class Derived>
+class ForecastProvider {
+public:
+    bool fetchForecast(ForecastData& data) {
+        return static_cast<Derived*>(this)->getForecast(data);
+    }
+
+protected:
+    ForecastProvider() {}
+};
+
+#endif  // WEATHER_PROVIDER_H
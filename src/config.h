@@ -32,6 +32,11 @@
 #ifndef NETATMO_DEVICE_ID
 #define NETATMO_DEVICE_ID "70:ee:50:19:27:82"
 #endif
+// 1: request all stations of the account; NETATMO_DEVICE_ID stays the main
+// station, the others are shown as extra rooms
+#ifndef NETATMO_ALL_STATIONS
+#define NETATMO_ALL_STATIONS 0
+#endif
 
 // Location Configuration (Davos coordinates for MeteoSwiss)
 #ifndef LOCATION_LAT
@@ -44,9 +49,26 @@
 #define LOCATION_NAME "Davos"
 #endif
 
-// MeteoSwiss Point ID (68 = Luzern)
+// Timezone as POSIX TZ rule (only "Mm.w.d/time" DST rules are supported).
+// The single definition used for all local-time conversions (time/local_time.h).
+#ifndef TIMEZONE
+#define TIMEZONE "CET-1CEST,M3.5.0,M10.5.0/3"  // CET/CEST, DST last Sunday Mar-Oct
+#endif
+
+// Data providers (compile-time, see api/providers.h)
+#define CONDITIONS_NETATMO 0
+#ifndef CONDITIONS_PROVIDER
+#define CONDITIONS_PROVIDER CONDITIONS_NETATMO
+#endif
+#define FORECAST_METNO 0
+#define FORECAST_METEOSWISS 1
+#ifndef FORECAST_PROVIDER
+#define FORECAST_PROVIDER FORECAST_METNO
+#endif
+
+// MeteoSwiss location: Swiss postal code followed by "00" (727000 = Davos)
 #ifndef METEOSWISS_POINT_ID
-#define METEOSWISS_POINT_ID 68
+#define METEOSWISS_POINT_ID 727000
 #endif
 
 // Update Configuration
@@ -83,10 +105,53 @@
 #define NTP_TIMEOUT_MS 15000  // 15 seconds
 #endif
 
+// HTTP Date header time sync (NTP is only used as fallback)
+#ifndef HTTP_DATE_MAX_DRIFT_SEC
+#define HTTP_DATE_MAX_DRIFT_SEC 300  // Larger offsets are treated as implausible
+#endif
+#ifndef HTTP_DATE_MIN_CORRECTION_SEC
+#define HTTP_DATE_MIN_CORRECTION_SEC 2  // Date has 1 s resolution, ignore smaller offsets
+#endif
+
+// RTC drift model (BM8563) and adaptive NTP scheduling
+#ifndef TIME_SYNC_MAX_ERROR_SEC
+#define TIME_SYNC_MAX_ERROR_SEC 20  // Predicted clock error that triggers a sync (wake margin is 60 s)
+#endif
+
+// A drift sample is the offset found at a sync over the RTC run time since it
+// was last written. Its error is at most RTC_DRIFT_SAMPLE_ERROR_SEC over that
+// run time (116 ppm for a 6 h baseline), so samples are averaged weighted by
+// their run time, and the model is trusted only after RTC_DRIFT_MIN_SAMPLES
+// samples agreed within their errors. The residual then is the larger of the
+// averaging error and RTC_DRIFT_RESIDUAL_PPM: what a fixed correction cannot
+// follow, i.e. the crystal's temperature curve (-0.034 ppm/°C², ~1 ppm over
+// +-5 °C indoors) plus aging over the averaging window (~1 ppm).
+#define RTC_DRIFT_UNMODELED_PPM 50         // Assumed worst-case drift until a model exists
+#define RTC_DRIFT_RESIDUAL_PPM 3           // Floor of the error once the drift is modelled
+#define RTC_DRIFT_SAMPLE_ERROR_SEC 2.5f    // RTC read and Date header 1 s resolution, RTC write and latency 0.5 s
+#define RTC_DRIFT_MIN_SAMPLES 3            // Agreeing samples before the model is trusted
+#define RTC_DRIFT_MIN_BASELINE_SEC 21600   // Minimum RTC run time for a drift sample (6 h)
+#define RTC_DRIFT_MAX_BASELINE_SEC 1209600 // Averaging window, older samples fade out (14 days)
+#define RTC_DRIFT_MAX_PPM 200              // Larger samples are rejected as bogus
+
+// LAN hub (optional): fetch one pre-digested frame from the hub daemon in hub/
+// instead of calling Netatmo and met.no directly. Empty host = disabled.
+#ifndef HUB_HOST
+#define HUB_HOST ""
+#endif
+#ifndef HUB_PORT
+#define HUB_PORT 8377
+#endif
+#ifndef HUB_TIMEOUT_MS
+#define HUB_TIMEOUT_MS 3000
+#endif
+
 // API Endpoints
 #define NETATMO_TOKEN_URL "https://api.netatmo.com/oauth2/token"
 #define NETATMO_WEATHER_URL "https://api.netatmo.com/api/getstationsdata"
+#define NETATMO_MEASURE_URL "https://api.netatmo.com/api/getmeasure"
 #define METEO_FORECAST_URL "https://api.met.no/weatherapi/locationforecast/2.0/compact"
+#define METEOSWISS_FORECAST_URL "https://app-prod-ws.meteoswiss-app.ch/v1/plzDetail"
 
 // HTTP Configuration
 #ifndef HTTP_TIMEOUT_MS
@@ -98,9 +163,33 @@
 #define HTTP_USER_AGENT "ESP32-Davos-WeatherDashboard/2.0 (github.com/yourusername/esp32netatmo)"
 #endif
 
+// JSON arena (PSRAM bump allocator for JsonDocument, see data/json_arena.h)
+#ifndef JSON_ARENA_SIZE
+#define JSON_ARENA_SIZE (512 * 1024)
+#endif
+
+// Persistent state (data/state_store.h), committed once per wake to two alternating slots
+#define STATE_SLOT_A "/state.a"
+#define STATE_SLOT_B "/state.b"
+#define WAKE_SLOT_A "/wake.a"  // Per-wake counters, kept apart so the state is rewritten only on changes
+#define WAKE_SLOT_B "/wake.b"
+#define STATE_LEGACY_FILE "/state.bin"  // Single-file state of older firmware, migrated
+#define WAKE_LEGACY_FILE "/wake.bin"
+
+// Erase cycles per flash sector for the lifetime projection (data/flash_wear.h)
+#ifndef FLASH_ENDURANCE_CYCLES
+#define FLASH_ENDURANCE_CYCLES 100000
+#endif
+
+// Measurement history (data/history_log.h): raw, hourly and daily ring logs
+#define HISTORY_DIR "/hist"
+
 // Cache Configuration
-#define CACHE_FILE "/weather_cache.json"
+#define CACHE_BIN_FILE "/weather_cache.bin"    // Caches of older firmware, migrated into the state
+#define CACHE_JSON_FILE "/weather_cache.json"
 #define CACHE_MAX_AGE_SEC 7200  // 2 hours
+#define HOURLY_FILE "/hourly.bin"  // Forecast timeseries (data/hourly_series.h)
+#define SNAPSHOT_FILE "/screen.rle"  // Last pushed screen (display/screen_snapshot.h)
 
 // Battery Voltage Thresholds (mV)
 #define BATTERY_MIN_MV 3300
@@ -0,0 +1,46 @@
+#ifdef ALLOC_COUNTER
+
+#include "alloc_counter.h"
+
+// Counters are updated from any task, hence the atomics
+static uint32_t mallocCount = 0;
+static uint32_t mallocBytes = 0;
+static uint32_t callocCount = 0;
+static uint32_t callocBytes = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    __atomic_add_fetch(&mallocCount, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&mallocBytes, size, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    __atomic_add_fetch(&callocCount, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&callocBytes, count * size, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    __atomic_add_fetch(&mallocCount, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&mallocBytes, size, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+}
+
+void AllocCounter::endPhase(const char* name) {
+    uint32_t mallocs = __atomic_exchange_n(&mallocCount, 0, __ATOMIC_RELAXED);
+    uint32_t mallocSize = __atomic_exchange_n(&mallocBytes, 0, __ATOMIC_RELAXED);
+    uint32_t callocs = __atomic_exchange_n(&callocCount, 0, __ATOMIC_RELAXED);
+    uint32_t callocSize = __atomic_exchange_n(&callocBytes, 0, __ATOMIC_RELAXED);
+
+    ESP_LOGI("alloc", "%s: %lu malloc/realloc (%lu bytes), %lu calloc (%lu bytes)",
+             name, (unsigned long)mallocs, (unsigned long)mallocSize,
+             (unsigned long)callocs, (unsigned long)callocSize);
+}
+
+#endif  // ALLOC_COUNTER
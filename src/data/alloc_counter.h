@@ -0,0 +1,26 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <Arduino.h>
+
+// Heap allocation counter for the wake (diagnostics only). Counts the
+// malloc/realloc and calloc calls seen by the linker's --wrap per phase, so
+// it is only active in the m5paper-alloc environment (platformio.ini),
+// which defines ALLOC_COUNTER and wraps the allocator functions.
+// Allocations made directly through heap_caps_malloc/heap_caps_calloc
+// (WiFi driver, mbedTLS if its platform hooks are set to them) are not seen.
+//
+// calloc is reported separately: the default mbedTLS allocator calls it,
+// while malloc/realloc are mostly the transient allocations of our own
+// code and of the Arduino HTTP/WiFi layers.
+class AllocCounter {
+public:
+#ifdef ALLOC_COUNTER
+    // Log the allocations since the previous phase and start a new one
+    static void endPhase(const char* name);
+#else
+    static void endPhase(const char*) {}
+#endif
+};
+
+#endif  // ALLOC_COUNTER_H
@@ -0,0 +1,80 @@
+#include "assets.h"
+#include <esp_partition.h>
+
+// Image layout written by scripts/assets.py
+struct __attribute__((packed)) AssetHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+};
+
+struct __attribute__((packed)) AssetEntry {
+    char name[48];          // NUL-terminated, relative to assets/
+    uint32_t offset;        // From the image start
+    uint32_t size;
+};
+
+static const uint32_t ASSET_MAGIC = 0x54535341;  // "ASST"
+static const uint16_t ASSET_VERSION = 1;
+
+static const uint8_t* image = nullptr;
+static size_t imageSize = 0;
+
+bool Assets::begin() {
+    if (image) {
+        return true;
+    }
+
+    const esp_partition_t* partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)ASSET_PARTITION_SUBTYPE, ASSET_PARTITION_LABEL);
+    if (!partition) {
+        ESP_LOGE("assets", "No assets partition (flash with partitions.csv)");
+        return false;
+    }
+
+    // Stays mapped until the device sleeps
+    const void* mapped;
+    spi_flash_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE("assets", "Failed to map assets partition: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    const AssetHeader* header = (const AssetHeader*)mapped;
+    if (header->magic != ASSET_MAGIC || header->version != ASSET_VERSION ||
+        sizeof(AssetHeader) + header->count * sizeof(AssetEntry) > partition->size) {
+        ESP_LOGE("assets", "Assets partition empty or invalid (pio run -t uploadassets)");
+        spi_flash_munmap(handle);
+        return false;
+    }
+
+    image = (const uint8_t*)mapped;
+    imageSize = partition->size;
+    ESP_LOGI("assets", "%u assets mapped", header->count);
+    return true;
+}
+
+const uint8_t* Assets::find(const char* name, size_t& size) {
+    if (!begin()) {
+        return nullptr;
+    }
+
+    const AssetHeader* header = (const AssetHeader*)image;
+    const AssetEntry* entries = (const AssetEntry*)(image + sizeof(AssetHeader));
+    for (uint16_t i = 0; i < header->count; i++) {
+        const AssetEntry& entry = entries[i];
+        if (strncmp(entry.name, name, sizeof(entry.name)) != 0) {
+            continue;
+        }
+        if (entry.offset > imageSize || entry.size > imageSize - entry.offset) {
+            ESP_LOGE("assets", "Asset %s out of bounds", name);
+            return nullptr;
+        }
+        size = entry.size;
+        return image + entry.offset;
+    }
+
+    ESP_LOGE("assets", "Asset %s not found", name);
+    return nullptr;
+}
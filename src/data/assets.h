@@ -0,0 +1,23 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <Arduino.h>
+
+// Static assets (fonts) in the "assets" data partition (partitions.csv),
+// packed from assets/ by scripts/assets.py and flashed separately with
+// `pio run -t uploadassets`. The partition is memory-mapped, so files are
+// read in place like const arrays, without being part of the app image.
+
+#define ASSET_PARTITION_LABEL "assets"
+#define ASSET_PARTITION_SUBTYPE 0x40
+
+class Assets {
+public:
+    // Map the partition (once); false if it is missing or was not flashed
+    static bool begin();
+
+    // Contents of a file ("fonts/LiberationSans-Regular.ttf"), nullptr if missing
+    static const uint8_t* find(const char* name, size_t& size);
+};
+
+#endif  // ASSETS_H
@@ -1,4 +1,34 @@
 #include "cache.h"
+#include "json_arena.h"
+#include "crc32.h"
+#include "compact_codec.h"
+#include "state_store.h"
+#include "flash_wear.h"
+#include "../power/sleep_manager.h"
+
+// Binary cache file of earlier firmware (CACHE_BIN_FILE), migrated into the state
+struct __attribute__((packed)) LegacyCacheRecord {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t crc;
+    uint32_t savedAt;
+    CompactDashboard data;
+};
+
+static const uint32_t LEGACY_CACHE_MAGIC = 0x48534144;  // "DASH"
+static const uint16_t LEGACY_CACHE_VERSION = 2;
+
+// Header of HOURLY_FILE, followed by the raw HourlySeries
+struct HourlyFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;          // sizeof(HourlySeries), catches layout changes
+    uint32_t crc;           // CRC-32 of the series bytes
+};
+
+static const uint32_t HOURLY_MAGIC = 0x594C5248;  // "HRLY"
+static const uint16_t HOURLY_VERSION = 1;
 
 bool DataCache::init() {
     if (!LittleFS.begin(true)) {  // Format if mount fails
@@ -10,259 +40,291 @@ bool DataCache::init() {
     ESP_LOGI("cache", "Total: %u bytes, Used: %u bytes",
             LittleFS.totalBytes(), LittleFS.usedBytes());
 
+    migrateLegacy();
     return true;
 }
 
 bool DataCache::save(const DashboardData& data) {
-    ESP_LOGI("cache", "Saving dashboard data to cache");
-
-    JsonDocument doc;
-
-    // Metadata
-    doc["cacheTime"] = millis();
-    doc["updateTime"] = data.updateTime;
-
-    // Indoor data
-    JsonObject indoor = doc["indoor"].to<JsonObject>();
-    indoor["temp"] = data.weather.indoor.temperature;
-    indoor["humidity"] = data.weather.indoor.humidity;
-    indoor["co2"] = data.weather.indoor.co2;
-    indoor["noise"] = data.weather.indoor.noise;
-    indoor["pressure"] = data.weather.indoor.pressure;
-    indoor["tempTrend"] = (int)data.weather.indoor.temperatureTrend;
-    indoor["pressTrend"] = (int)data.weather.indoor.pressureTrend;
-    indoor["co2Trend"] = (int)data.weather.indoor.co2Trend;
-    indoor["minTemp"] = data.weather.indoor.minTemp;
-    indoor["maxTemp"] = data.weather.indoor.maxTemp;
-    indoor["valid"] = data.weather.indoor.valid;
-
-    // Outdoor data
-    JsonObject outdoor = doc["outdoor"].to<JsonObject>();
-    outdoor["temp"] = data.weather.outdoor.temperature;
-    outdoor["humidity"] = data.weather.outdoor.humidity;
-    outdoor["tempTrend"] = (int)data.weather.outdoor.temperatureTrend;
-    outdoor["minTemp"] = data.weather.outdoor.minTemp;
-    outdoor["maxTemp"] = data.weather.outdoor.maxTemp;
-    outdoor["valid"] = data.weather.outdoor.valid;
+    // Kept in the state store, written with it at the end of the wake
+    CachedDashboard& cache = StateStore::state().cache;
+    CachedModuleTimes& cachedTimes = StateStore::state().cacheModules;
+    CompactDashboard packed;
+    CompactCodec::pack(data, packed);
+
+    const WeatherData& weather = data.weather;
+    CachedModuleTimes times;
+    times.indoor = weather.indoor.cachedTime;
+    times.outdoor = weather.outdoor.cachedTime;
+    times.wind = weather.wind.cachedTime;
+    times.rain = weather.rain.cachedTime;
+
+    // Same data as cached (no new measurement or forecast): keep savedAt, so
+    // the state is not rewritten and the cache age stays that of the data
+    if (cache.savedAt != 0 && memcmp(&packed, &cache.data, sizeof(packed)) == 0 &&
+        memcmp(&times, &cachedTimes, sizeof(times)) == 0) {
+        ESP_LOGI("cache", "Dashboard data unchanged, cache kept");
+        return true;
+    }
 
-    // Forecast current
-    JsonObject current = doc["current"].to<JsonObject>();
-    current["temp"] = data.forecast.current.temperature;
-    current["code"] = data.forecast.current.weatherCode;
-    current["humidity"] = data.forecast.current.humidity;
-    current["valid"] = data.forecast.current.valid;
-
-    // Forecast 3h
-    JsonObject f3h = doc["forecast3h"].to<JsonObject>();
-    f3h["temp"] = data.forecast.forecast3h.temperature;
-    f3h["code"] = data.forecast.forecast3h.weatherCode;
-    f3h["precip"] = data.forecast.forecast3h.precipitation;
-    f3h["valid"] = data.forecast.forecast3h.valid;
-
-    // Forecast 6h
-    JsonObject f6h = doc["forecast6h"].to<JsonObject>();
-    f6h["temp"] = data.forecast.forecast6h.temperature;
-    f6h["code"] = data.forecast.forecast6h.weatherCode;
-    f6h["precip"] = data.forecast.forecast6h.precipitation;
-    f6h["valid"] = data.forecast.forecast6h.valid;
+    cache.data = packed;
+    cachedTimes = times;
+    cache.savedAt = (uint32_t)SleepManager::getEpoch();
 
-    // 4-day forecast (met.no)
-    JsonArray days = doc["days"].to<JsonArray>();
-    for (int i = 0; i < 4; i++) {
-        JsonObject day = days.add<JsonObject>();
-        day["date"] = data.forecast.days[i].date;
-        day["tempMin"] = data.forecast.days[i].tempMin;
-        day["tempMax"] = data.forecast.days[i].tempMax;
-        day["symbol"] = data.forecast.days[i].symbolCode;
-        day["precipSum"] = data.forecast.days[i].precipSum;
-        day["windMax"] = data.forecast.days[i].windSpeedMax;
-        day["windDir"] = data.forecast.days[i].windDirection;
-        day["valid"] = data.forecast.days[i].valid;
+    ESP_LOGI("cache", "Dashboard data cached (%u bytes)", (unsigned)sizeof(cache));
+    return true;
+}
 
-        // Day-time forecast (3 times: 06:00, 12:00, 18:00)
-        JsonArray times = day["times"].to<JsonArray>();
-        for (int t = 0; t < 3; t++) {
-            JsonObject time = times.add<JsonObject>();
-            time["h"] = data.forecast.days[i].times[t].hour;
-            time["t"] = data.forecast.days[i].times[t].temperature;
-            time["s"] = data.forecast.days[i].times[t].symbolCode;
-            time["p"] = data.forecast.days[i].times[t].precipitationMm;
-        }
+bool DataCache::load(DashboardData& data) {
+    const CachedDashboard& cache = StateStore::state().cache;
+    if (cache.savedAt == 0 || cache.data.roomCount > COMPACT_MAX_ROOMS) {
+        ESP_LOGW("cache", "No cached data");
+        return false;
     }
 
-    // Battery
-    doc["batteryMv"] = data.batteryVoltage;
-    doc["batteryPct"] = data.batteryPercent;
+    // Check cache age
+    unsigned long ageSec = getAgeSeconds();
+    ESP_LOGI("cache", "Cache age: %lu seconds", ageSec);
 
-    // Write to file
-    File file = LittleFS.open(CACHE_FILE, "w");
-    if (!file) {
-        ESP_LOGE("cache", "Failed to open cache file for writing");
+    if (ageSec > CACHE_MAX_AGE_SEC) {
+        ESP_LOGW("cache", "Cache is too old (> %d seconds)", CACHE_MAX_AGE_SEC);
         return false;
     }
 
-    size_t written = serializeJson(doc, file);
-    file.close();
+    CompactCodec::unpack(cache.data, data);
 
-    if (written == 0) {
-        ESP_LOGE("cache", "Failed to write cache file");
-        return false;
-    }
+    const CachedModuleTimes& times = StateStore::state().cacheModules;
+    data.weather.indoor.cachedTime = times.indoor;
+    data.weather.outdoor.cachedTime = times.outdoor;
+    data.weather.wind.cachedTime = times.wind;
+    data.weather.rain.cachedTime = times.rain;
 
-    ESP_LOGI("cache", "Cache saved: %u bytes", written);
+    ESP_LOGI("cache", "Cache loaded successfully");
     return true;
 }
 
-bool DataCache::load(DashboardData& data) {
-    if (!LittleFS.exists(CACHE_FILE)) {
-        ESP_LOGW("cache", "Cache file does not exist");
-        return false;
+bool DataCache::isValid() {
+    return (getAgeSeconds() <= CACHE_MAX_AGE_SEC);
+}
+
+unsigned long DataCache::getAgeSeconds() {
+    uint32_t savedAt = StateStore::state().cache.savedAt;
+    if (savedAt == 0) {
+        return UINT32_MAX;  // Very old
+    }
+
+    // A clock that went backwards (RTC lost) reads as fresh rather than expired
+    time_t now = SleepManager::getEpoch();
+    return now > (time_t)savedAt ? (unsigned long)(now - savedAt) : 0;
+}
+
+// One-time conversion of the cache files of earlier firmware into the state
+void DataCache::migrateLegacy() {
+    CachedDashboard& cache = StateStore::state().cache;
+
+    if (LittleFS.exists(CACHE_BIN_FILE)) {
+        File file = LittleFS.open(CACHE_BIN_FILE, "r");
+        LegacyCacheRecord record;
+        bool ok = file && file.read((uint8_t*)&record, sizeof(record)) == sizeof(record) &&
+                  record.magic == LEGACY_CACHE_MAGIC && record.version == LEGACY_CACHE_VERSION &&
+                  record.size == sizeof(record.data) &&
+                  crc32(&record.data, sizeof(record.data)) == record.crc;
+        if (file) {
+            file.close();
+        }
+        LittleFS.remove(CACHE_BIN_FILE);
+
+        if (ok) {
+            cache.data = record.data;
+            cache.savedAt = record.savedAt;
+            ESP_LOGI("cache", "Binary cache migrated");
+        }
+    }
+
+    if (LittleFS.exists(CACHE_JSON_FILE)) {
+        if (cache.savedAt == 0) {
+            migrateJSON();
+        }
+        LittleFS.remove(CACHE_JSON_FILE);
     }
+}
 
-    File file = LittleFS.open(CACHE_FILE, "r");
+// JSON cache of earlier firmware (CACHE_JSON_FILE)
+void DataCache::migrateJSON() {
+    File file = LittleFS.open(CACHE_JSON_FILE, "r");
     if (!file) {
-        ESP_LOGE("cache", "Failed to open cache file for reading");
-        return false;
+        return;
     }
 
-    JsonDocument doc;
+    JsonDocument doc(JsonArena::instance());
     DeserializationError error = deserializeJson(doc, file);
     file.close();
 
-    if (error) {
-        ESP_LOGE("cache", "Failed to parse cache file: %s", error.c_str());
-        return false;
+    // Files written before the fixed-point layout have no "forecast" object
+    JsonObject forecast = doc["forecast"];
+    if (error || !forecast) {
+        ESP_LOGW("cache", "Legacy cache file unreadable, dropped");
+        return;
     }
 
-    // Check cache age
-    unsigned long cacheTime = doc["cacheTime"] | 0;
-    unsigned long ageMs = millis() - cacheTime;
-    unsigned long ageSec = ageMs / 1000;
+    CompactDashboard compact;
+    memset(&compact, 0, sizeof(compact));
 
-    ESP_LOGI("cache", "Cache age: %lu seconds", ageSec);
-
-    if (ageSec > CACHE_MAX_AGE_SEC) {
-        ESP_LOGW("cache", "Cache is too old (> %d seconds)", CACHE_MAX_AGE_SEC);
-        return false;
-    }
-
-    // Load data
-    data.updateTime = doc["updateTime"] | 0;
+    // Metadata
+    compact.timestamp = doc["timestamp"] | 0;
+    strncpy(compact.stationName, doc["station"] | "", sizeof(compact.stationName) - 1);
 
     // Indoor data
     JsonObject indoor = doc["indoor"];
-    data.weather.indoor.temperature = indoor["temp"] | 0.0f;
-    data.weather.indoor.humidity = indoor["humidity"] | 0;
-    data.weather.indoor.co2 = indoor["co2"] | 0;
-    data.weather.indoor.noise = indoor["noise"] | 0;
-    data.weather.indoor.pressure = indoor["pressure"] | 0;
-    data.weather.indoor.temperatureTrend = (Trend)(indoor["tempTrend"] | 0);
-    data.weather.indoor.pressureTrend = (Trend)(indoor["pressTrend"] | 0);
-    data.weather.indoor.co2Trend = (Trend)(indoor["co2Trend"] | 0);
-    data.weather.indoor.minTemp = indoor["minTemp"] | 0.0f;
-    data.weather.indoor.maxTemp = indoor["maxTemp"] | 0.0f;
-    data.weather.indoor.valid = indoor["valid"] | false;
+    compact.indoor.temperature = indoor["temp"] | 0;
+    compact.indoor.minTemp = indoor["min"] | 0;
+    compact.indoor.maxTemp = indoor["max"] | 0;
+    compact.indoor.minTempAge = indoor["minAge"] | COMPACT_NO_TIME;
+    compact.indoor.maxTempAge = indoor["maxAge"] | COMPACT_NO_TIME;
+    compact.indoor.co2 = indoor["co2"] | 0;
+    compact.indoor.pressure = indoor["pressure"] | 0;
+    compact.indoor.humidity = indoor["humidity"] | 0;
+    compact.indoor.noise = indoor["noise"] | 0;
+    compact.indoor.temperatureTrend = indoor["tempTrend"] | COMPACT_TREND_UNKNOWN;
+    compact.indoor.pressureTrend = indoor["pressTrend"] | COMPACT_TREND_UNKNOWN;
+    compact.indoor.co2Trend = indoor["co2Trend"] | COMPACT_TREND_UNKNOWN;
+    compact.indoor.valid = indoor["valid"] | 0;
 
     // Outdoor data
     JsonObject outdoor = doc["outdoor"];
-    data.weather.outdoor.temperature = outdoor["temp"] | 0.0f;
-    data.weather.outdoor.humidity = outdoor["humidity"] | 0;
-    data.weather.outdoor.temperatureTrend = (Trend)(outdoor["tempTrend"] | 0);
-    data.weather.outdoor.minTemp = outdoor["minTemp"] | 0.0f;
-    data.weather.outdoor.maxTemp = outdoor["maxTemp"] | 0.0f;
-    data.weather.outdoor.valid = outdoor["valid"] | false;
+    compact.outdoor.temperature = outdoor["temp"] | 0;
+    compact.outdoor.minTemp = outdoor["min"] | 0;
+    compact.outdoor.maxTemp = outdoor["max"] | 0;
+    compact.outdoor.minTempAge = outdoor["minAge"] | COMPACT_NO_TIME;
+    compact.outdoor.maxTempAge = outdoor["maxAge"] | COMPACT_NO_TIME;
+    compact.outdoor.humidity = outdoor["humidity"] | 0;
+    compact.outdoor.temperatureTrend = outdoor["tempTrend"] | COMPACT_TREND_UNKNOWN;
+    compact.outdoor.valid = outdoor["valid"] | 0;
+
+    // Wind and rain modules
+    JsonObject wind = doc["wind"];
+    compact.wind.strength = wind["strength"] | 0;
+    compact.wind.angle = wind["angle"] | 0;
+    compact.wind.gustStrength = wind["gust"] | 0;
+    compact.wind.gustAngle = wind["gustAngle"] | 0;
+    compact.wind.maxWindStrength = wind["max"] | 0;
+    compact.wind.maxWindAge = wind["maxAge"] | COMPACT_NO_TIME;
+    compact.wind.valid = wind["valid"] | 0;
+
+    JsonObject rain = doc["rain"];
+    compact.rain.current = rain["current"] | 0;
+    compact.rain.sum1h = rain["sum1h"] | 0;
+    compact.rain.sum24h = rain["sum24h"] | 0;
+    compact.rain.valid = rain["valid"] | 0;
+
+    // Extra rooms
+    JsonArray rooms = doc["rooms"];
+    for (JsonObject room : rooms) {
+        if (compact.roomCount >= COMPACT_MAX_ROOMS) break;
+        CompactRoom& dst = compact.rooms[compact.roomCount++];
+        strncpy(dst.name, room["name"] | "", sizeof(dst.name) - 1);
+        dst.temperature = room["temp"] | 0;
+        dst.co2 = room["co2"] | 0;
+        dst.humidity = room["humidity"] | 0;
+        dst.temperatureTrend = room["tempTrend"] | COMPACT_TREND_UNKNOWN;
+        dst.valid = room["valid"] | 0;
+    }
 
     // Forecast current
-    JsonObject current = doc["current"];
-    data.forecast.current.temperature = current["temp"] | 0.0f;
-    data.forecast.current.weatherCode = current["code"] | 0;
-    data.forecast.current.humidity = current["humidity"] | 0;
-    data.forecast.current.valid = current["valid"] | false;
-
-    // Forecast 3h
-    JsonObject f3h = doc["forecast3h"];
-    data.forecast.forecast3h.temperature = f3h["temp"] | 0.0f;
-    data.forecast.forecast3h.weatherCode = f3h["code"] | 0;
-    data.forecast.forecast3h.precipitation = f3h["precip"] | 0.0f;
-    data.forecast.forecast3h.valid = f3h["valid"] | false;
-
-    // Forecast 6h
-    JsonObject f6h = doc["forecast6h"];
-    data.forecast.forecast6h.temperature = f6h["temp"] | 0.0f;
-    data.forecast.forecast6h.weatherCode = f6h["code"] | 0;
-    data.forecast.forecast6h.precipitation = f6h["precip"] | 0.0f;
-    data.forecast.forecast6h.valid = f6h["valid"] | false;
+    compact.forecast.baseDate = forecast["base"] | 0;
+    compact.forecast.currentTemp = forecast["temp"] | 0;
+    compact.forecast.currentCode = forecast["code"] | 0;
+    compact.forecast.currentValid = forecast["valid"] | 0;
 
     // 4-day forecast (met.no)
-    JsonArray days = doc["days"];
-    if (days) {
-        for (int i = 0; i < 4 && i < days.size(); i++) {
-            JsonObject day = days[i];
-            data.forecast.days[i].date = day["date"] | 0;
-            data.forecast.days[i].tempMin = day["tempMin"] | 0;
-            data.forecast.days[i].tempMax = day["tempMax"] | 0;
-            data.forecast.days[i].symbolCode = day["symbol"] | 0;
-            data.forecast.days[i].precipSum = day["precipSum"] | 0;
-            data.forecast.days[i].windSpeedMax = day["windMax"] | 0;
-            data.forecast.days[i].windDirection = day["windDir"] | 0;
-            data.forecast.days[i].valid = day["valid"] | false;
-
-            // Day-time forecast (3 times: 06:00, 12:00, 18:00)
-            JsonArray times = day["times"];
-            if (times) {
-                for (int t = 0; t < 3 && t < times.size(); t++) {
-                    JsonObject time = times[t];
-                    data.forecast.days[i].times[t].hour = time["h"] | 0;
-                    data.forecast.days[i].times[t].temperature = time["t"] | 0;
-                    data.forecast.days[i].times[t].symbolCode = time["s"] | 0;
-                    data.forecast.days[i].times[t].precipitationMm = time["p"] | 0;
-                }
-            }
+    JsonArray days = forecast["days"];
+    for (int i = 0; i < 4 && i < (int)days.size(); i++) {
+        JsonObject day = days[i];
+        CompactDay& dst = compact.forecast.days[i];
+        dst.dateOffset = day["offset"] | COMPACT_NO_TIME;
+        dst.tempMin = day["tempMin"] | 0;
+        dst.tempMax = day["tempMax"] | 0;
+        dst.symbolCode = day["symbol"] | 0;
+        dst.precipSum = day["precipSum"] | 0;
+        dst.windSpeedMax = day["windMax"] | 0;
+        dst.windDirection = day["windDir"] | 0;
+        dst.valid = day["valid"] | 0;
+
+        // Day-time forecast (3 times: 06:00, 12:00, 18:00)
+        JsonArray times = day["times"];
+        for (int t = 0; t < 3 && t < (int)times.size(); t++) {
+            JsonObject time = times[t];
+            dst.times[t].hour = time["h"] | 0;
+            dst.times[t].temperature = time["t"] | 0;
+            dst.times[t].symbolCode = time["s"] | 0;
+            dst.times[t].precipitation = time["p"] | 0;
         }
     }
 
-    // Battery
-    data.batteryVoltage = doc["batteryMv"] | 0;
-    data.batteryPercent = doc["batteryPct"] | 0;
+    // The JSON cacheTime was millis() of an earlier boot: age from the
+    // Netatmo measurement time instead (never younger than the data)
+    CachedDashboard& cache = StateStore::state().cache;
+    cache.data = compact;
+    cache.savedAt = compact.timestamp;
+    ESP_LOGI("cache", "JSON cache migrated");
+}
 
-    ESP_LOGI("cache", "Cache loaded successfully");
-    return true;
+void DataCache::clear() {
+    memset(&StateStore::state().cache, 0, sizeof(CachedDashboard));
+    ESP_LOGI("cache", "Cache cleared");
 }
 
-bool DataCache::isValid() {
-    if (!LittleFS.exists(CACHE_FILE)) {
+bool DataCache::saveHourly(const HourlySeries& series) {
+    HourlyFileHeader header = {HOURLY_MAGIC, HOURLY_VERSION, (uint16_t)sizeof(series),
+                               crc32(&series, sizeof(series))};
+
+    FlashWear::fileWritten();
+    File file = LittleFS.open(HOURLY_FILE, "w");
+    if (!file) {
+        ESP_LOGE("cache", "Failed to open hourly file for writing");
         return false;
     }
 
-    return (getAgeSeconds() <= CACHE_MAX_AGE_SEC);
+    size_t written = file.write((const uint8_t*)&header, sizeof(header));
+    written += file.write((const uint8_t*)&series, sizeof(series));
+    file.close();
+
+    if (written != sizeof(header) + sizeof(series)) {
+        ESP_LOGE("cache", "Failed to write hourly file");
+        LittleFS.remove(HOURLY_FILE);
+        return false;
+    }
+
+    ESP_LOGI("cache", "Hourly series saved: %u points, %u bytes", series.count, written);
+    return true;
 }
 
-unsigned long DataCache::getAgeSeconds() {
-    if (!LittleFS.exists(CACHE_FILE)) {
-        return UINT32_MAX;  // Very old
+bool DataCache::loadHourly(HourlySeries& series) {
+    series.clear();
+    if (!LittleFS.exists(HOURLY_FILE)) {
+        return false;
     }
 
-    File file = LittleFS.open(CACHE_FILE, "r");
+    File file = LittleFS.open(HOURLY_FILE, "r");
     if (!file) {
-        return UINT32_MAX;
+        ESP_LOGE("cache", "Failed to open hourly file for reading");
+        return false;
     }
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
+    HourlyFileHeader header;
+    bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              header.magic == HOURLY_MAGIC && header.version == HOURLY_VERSION &&
+              header.size == sizeof(series) &&
+              file.read((uint8_t*)&series, sizeof(series)) == sizeof(series) &&
+              crc32(&series, sizeof(series)) == header.crc &&
+              series.count <= HOURLY_SERIES_CAPACITY;
     file.close();
 
-    if (error) {
-        return UINT32_MAX;
+    if (!ok) {
+        ESP_LOGW("cache", "Hourly file invalid, ignoring");
+        series.clear();
+        return false;
     }
 
-    unsigned long cacheTime = doc["cacheTime"] | 0;
-    unsigned long ageMs = millis() - cacheTime;
-    return ageMs / 1000;
-}
-
-void DataCache::clear() {
-    if (LittleFS.exists(CACHE_FILE)) {
-        LittleFS.remove(CACHE_FILE);
-        ESP_LOGI("cache", "Cache cleared");
-    }
+    ESP_LOGI("cache", "Hourly series loaded: %u points", series.count);
+    return series.count > 0;
 }
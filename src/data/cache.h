@@ -12,20 +12,29 @@ public:
     // Initialize LittleFS
     static bool init();
 
-    // Save dashboard data to cache
+    // Save dashboard data to cache (CompactDashboard in the state store)
     static bool save(const DashboardData& data);
 
     // Load dashboard data from cache
     static bool load(DashboardData& data);
 
-    // Check if cache exists and is valid
+    // Check if cache exists and is not older than CACHE_MAX_AGE_SEC
     static bool isValid();
 
-    // Get cache age in seconds
+    // Cache age in seconds, UINT32_MAX if there is none
     static unsigned long getAgeSeconds();
 
     // Clear cache
     static void clear();
+
+    // Save/load the forecast hourly series (binary, CRC-checked)
+    static bool saveHourly(const HourlySeries& series);
+    static bool loadHourly(HourlySeries& series);
+
+private:
+    // Move CACHE_BIN_FILE / CACHE_JSON_FILE into the state store and delete them
+    static void migrateLegacy();
+    static void migrateJSON();
 };
 
 #endif  // CACHE_H
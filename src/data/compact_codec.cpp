@@ -0,0 +1,184 @@
+#include "compact_codec.h"
+
+static_assert(COMPACT_MAX_ROOMS == MAX_ROOMS, "Room slots differ between DashboardData and CompactDashboard");
+
+void CompactCodec::pack(const DashboardData& data, CompactDashboard& compact) {
+    memset(&compact, 0, sizeof(compact));
+
+    const WeatherData& weather = data.weather;
+    uint32_t timestamp = weather.timestamp;
+    compact.timestamp = timestamp;
+    strncpy(compact.stationName, weather.stationName.c_str(), sizeof(compact.stationName) - 1);
+
+    const IndoorData& indoor = weather.indoor;
+    compact.indoor.temperature = compactDeci(indoor.temperature);
+    compact.indoor.minTemp = compactDeci(indoor.minTemp);
+    compact.indoor.maxTemp = compactDeci(indoor.maxTemp);
+    compact.indoor.minTempAge = compactMinutes(indoor.dateMinTemp, timestamp);
+    compact.indoor.maxTempAge = compactMinutes(indoor.dateMaxTemp, timestamp);
+    compact.indoor.co2 = indoor.co2;
+    compact.indoor.pressure = indoor.pressure;
+    compact.indoor.humidity = indoor.humidity;
+    compact.indoor.noise = indoor.noise;
+    compact.indoor.temperatureTrend = (uint8_t)indoor.temperatureTrend;
+    compact.indoor.pressureTrend = (uint8_t)indoor.pressureTrend;
+    compact.indoor.co2Trend = (uint8_t)indoor.co2Trend;
+    compact.indoor.valid = indoor.valid;
+
+    const OutdoorData& outdoor = weather.outdoor;
+    compact.outdoor.temperature = compactDeci(outdoor.temperature);
+    compact.outdoor.minTemp = compactDeci(outdoor.minTemp);
+    compact.outdoor.maxTemp = compactDeci(outdoor.maxTemp);
+    compact.outdoor.minTempAge = compactMinutes(outdoor.dateMinTemp, timestamp);
+    compact.outdoor.maxTempAge = compactMinutes(outdoor.dateMaxTemp, timestamp);
+    compact.outdoor.humidity = outdoor.humidity;
+    compact.outdoor.temperatureTrend = (uint8_t)outdoor.temperatureTrend;
+    compact.outdoor.valid = outdoor.valid;
+
+    const WindData& wind = weather.wind;
+    compact.wind.strength = wind.strength;
+    compact.wind.angle = wind.angle;
+    compact.wind.gustStrength = wind.gustStrength;
+    compact.wind.gustAngle = wind.gustAngle;
+    compact.wind.maxWindStrength = wind.maxWindStrength;
+    compact.wind.maxWindAge = compactMinutes(wind.dateMaxWind, timestamp);
+    compact.wind.valid = wind.valid;
+
+    const RainData& rain = weather.rain;
+    compact.rain.current = compactDeciUnsigned(rain.current);
+    compact.rain.sum1h = compactDeciUnsigned(rain.sum1h);
+    compact.rain.sum24h = compactDeciUnsigned(rain.sum24h);
+    compact.rain.valid = rain.valid;
+
+    compact.roomCount = weather.roomCount;
+    for (int i = 0; i < weather.roomCount; i++) {
+        const RoomData& src = weather.rooms[i];
+        CompactRoom& room = compact.rooms[i];
+        strncpy(room.name, src.name, sizeof(room.name) - 1);
+        room.temperature = compactDeci(src.temperature);
+        room.co2 = src.co2;
+        room.humidity = src.humidity;
+        room.temperatureTrend = (uint8_t)src.temperatureTrend;
+        room.valid = src.valid;
+    }
+
+    const ForecastData& forecast = data.forecast;
+    CompactForecast& cf = compact.forecast;
+    cf.baseDate = forecast.days[0].date;
+    cf.currentTemp = compactDeci(forecast.current.temperature);
+    cf.currentCode = forecast.current.weatherCode;
+    cf.currentValid = forecast.current.valid;
+
+    for (int i = 0; i < 4; i++) {
+        const DailyForecast& src = forecast.days[i];
+        CompactDay& day = cf.days[i];
+        day.dateOffset = compactMinutes(cf.baseDate, src.date);
+        day.tempMin = src.tempMin;
+        day.tempMax = src.tempMax;
+        day.symbolCode = src.symbolCode;
+        day.precipSum = src.precipSum;
+        day.windSpeedMax = src.windSpeedMax;
+        day.windDirection = (uint8_t)((src.windDirection % 360) / 2);
+        day.valid = src.valid;
+
+        for (int t = 0; t < 3; t++) {
+            day.times[t].hour = src.times[t].hour;
+            day.times[t].temperature = src.times[t].temperature;
+            day.times[t].symbolCode = src.times[t].symbolCode;
+            day.times[t].precipitation = src.times[t].precipitationMm;
+        }
+    }
+}
+
+void CompactCodec::unpack(const CompactDashboard& compact, DashboardData& data) {
+    WeatherData& weather = data.weather;
+    uint32_t timestamp = compact.timestamp;
+    weather.timestamp = timestamp;
+
+    char stationName[sizeof(compact.stationName) + 1];
+    memcpy(stationName, compact.stationName, sizeof(compact.stationName));
+    stationName[sizeof(compact.stationName)] = '\0';
+    weather.stationName = stationName;
+
+    IndoorData& indoor = weather.indoor;
+    indoor.temperature = compactFromDeci(compact.indoor.temperature);
+    indoor.minTemp = compactFromDeci(compact.indoor.minTemp);
+    indoor.maxTemp = compactFromDeci(compact.indoor.maxTemp);
+    indoor.dateMinTemp = compactAgeToEpoch(timestamp, compact.indoor.minTempAge);
+    indoor.dateMaxTemp = compactAgeToEpoch(timestamp, compact.indoor.maxTempAge);
+    indoor.co2 = compact.indoor.co2;
+    indoor.pressure = compact.indoor.pressure;
+    indoor.humidity = compact.indoor.humidity;
+    indoor.noise = compact.indoor.noise;
+    indoor.temperatureTrend = (Trend)compact.indoor.temperatureTrend;
+    indoor.pressureTrend = (Trend)compact.indoor.pressureTrend;
+    indoor.co2Trend = (Trend)compact.indoor.co2Trend;
+    indoor.valid = compact.indoor.valid;
+
+    OutdoorData& outdoor = weather.outdoor;
+    outdoor.temperature = compactFromDeci(compact.outdoor.temperature);
+    outdoor.minTemp = compactFromDeci(compact.outdoor.minTemp);
+    outdoor.maxTemp = compactFromDeci(compact.outdoor.maxTemp);
+    outdoor.dateMinTemp = compactAgeToEpoch(timestamp, compact.outdoor.minTempAge);
+    outdoor.dateMaxTemp = compactAgeToEpoch(timestamp, compact.outdoor.maxTempAge);
+    outdoor.humidity = compact.outdoor.humidity;
+    outdoor.temperatureTrend = (Trend)compact.outdoor.temperatureTrend;
+    outdoor.valid = compact.outdoor.valid;
+
+    WindData& wind = weather.wind;
+    wind.strength = compact.wind.strength;
+    wind.angle = compact.wind.angle;
+    wind.gustStrength = compact.wind.gustStrength;
+    wind.gustAngle = compact.wind.gustAngle;
+    wind.maxWindStrength = compact.wind.maxWindStrength;
+    wind.dateMaxWind = compactAgeToEpoch(timestamp, compact.wind.maxWindAge);
+    wind.valid = compact.wind.valid;
+
+    RainData& rain = weather.rain;
+    rain.current = compactFromDeci(compact.rain.current);
+    rain.sum1h = compactFromDeci(compact.rain.sum1h);
+    rain.sum24h = compactFromDeci(compact.rain.sum24h);
+    rain.valid = compact.rain.valid;
+
+    weather.roomCount = compact.roomCount < MAX_ROOMS ? compact.roomCount : MAX_ROOMS;
+    for (int i = 0; i < weather.roomCount; i++) {
+        const CompactRoom& src = compact.rooms[i];
+        RoomData& room = weather.rooms[i];
+        memcpy(room.name, src.name, sizeof(room.name));
+        room.name[sizeof(room.name) - 1] = '\0';
+        room.temperature = compactFromDeci(src.temperature);
+        room.co2 = src.co2;
+        room.humidity = src.humidity;
+        room.temperatureTrend = (Trend)src.temperatureTrend;
+        room.valid = src.valid;
+    }
+
+    unpackForecast(compact.forecast, data.forecast);
+}
+
+void CompactCodec::unpackForecast(const CompactForecast& cf, ForecastData& forecast) {
+    forecast.current = ForecastPoint();
+    forecast.current.temperature = compactFromDeci(cf.currentTemp);
+    forecast.current.weatherCode = cf.currentCode;
+    forecast.current.valid = cf.currentValid;
+
+    for (int i = 0; i < 4; i++) {
+        const CompactDay& src = cf.days[i];
+        DailyForecast& day = forecast.days[i];
+        day.date = compactOffsetToEpoch(cf.baseDate, src.dateOffset);
+        day.tempMin = src.tempMin;
+        day.tempMax = src.tempMax;
+        day.symbolCode = src.symbolCode;
+        day.precipSum = src.precipSum;
+        day.windSpeedMax = src.windSpeedMax;
+        day.windDirection = src.windDirection * 2;
+        day.valid = src.valid;
+
+        for (int t = 0; t < 3; t++) {
+            day.times[t].hour = src.times[t].hour;
+            day.times[t].temperature = src.times[t].temperature;
+            day.times[t].symbolCode = src.times[t].symbolCode;
+            day.times[t].precipitationMm = src.times[t].precipitation;
+        }
+    }
+}
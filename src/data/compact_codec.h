@@ -0,0 +1,19 @@
+#ifndef COMPACT_CODEC_H
+#define COMPACT_CODEC_H
+
+#include "weather_data.h"
+#include "compact_data.h"
+
+// Conversion between DashboardData and its fixed-point form (compact_data.h).
+// Battery, update/wake times and the hourly series are per-wake or stored
+// separately and are not part of the compact record.
+class CompactCodec {
+public:
+    static void pack(const DashboardData& data, CompactDashboard& compact);
+    static void unpack(const CompactDashboard& compact, DashboardData& data);
+
+    // Forecast part only (days and current point; the hourly series is untouched)
+    static void unpackForecast(const CompactForecast& compact, ForecastData& forecast);
+};
+
+#endif  // COMPACT_CODEC_H
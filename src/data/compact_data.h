@@ -0,0 +1,154 @@
+#ifndef COMPACT_DATA_H
+#define COMPACT_DATA_H
+
+#include <stdint.h>
+
+// Fixed-point DashboardData used wherever it is stored or sent: the LAN hub
+// frame and the cache. Plain C++ (no Arduino) so the hub daemon (hub/)
+// fills the same struct; CompactCodec (compact_codec.h) converts on the
+// display side.
+//
+// Conventions:
+//   temperatures        int16 0.1 °C
+//   precipitation       uint16 0.1 mm (daily sums no longer wrap at 25.5 mm)
+//   measurement times   uint16 minutes before CompactDashboard::timestamp
+//   forecast days       uint16 minutes after CompactForecast::baseDate
+// Structs are packed, little-endian.
+
+#define COMPACT_NO_TIME 0xFFFF  // Time offset not set (epoch 0)
+#define COMPACT_MAX_ROOMS 4     // Same as MAX_ROOMS in weather_data.h
+
+// Trend values (same order as enum class Trend in weather_data.h)
+#define COMPACT_TREND_STABLE 0
+#define COMPACT_TREND_UP 1
+#define COMPACT_TREND_DOWN 2
+#define COMPACT_TREND_UNKNOWN 3
+
+struct __attribute__((packed)) CompactIndoor {
+    int16_t temperature;        // 0.1 °C
+    int16_t minTemp;            // Daily minimum, 0.1 °C
+    int16_t maxTemp;            // Daily maximum, 0.1 °C
+    uint16_t minTempAge;        // Minutes before timestamp
+    uint16_t maxTempAge;
+    uint16_t co2;               // ppm
+    uint16_t pressure;          // mbar
+    uint8_t humidity;           // %
+    uint8_t noise;              // dB
+    uint8_t temperatureTrend;   // COMPACT_TREND_*
+    uint8_t pressureTrend;
+    uint8_t co2Trend;
+    uint8_t valid;
+};
+
+struct __attribute__((packed)) CompactOutdoor {
+    int16_t temperature;
+    int16_t minTemp;
+    int16_t maxTemp;
+    uint16_t minTempAge;
+    uint16_t maxTempAge;
+    uint8_t humidity;
+    uint8_t temperatureTrend;
+    uint8_t valid;
+};
+
+struct __attribute__((packed)) CompactWind {
+    uint16_t strength;          // km/h
+    uint16_t angle;             // degrees
+    uint16_t gustStrength;      // km/h
+    uint16_t gustAngle;         // degrees
+    uint16_t maxWindStrength;   // Daily max km/h
+    uint16_t maxWindAge;        // Minutes before timestamp
+    uint8_t valid;
+};
+
+struct __attribute__((packed)) CompactRain {
+    uint16_t current;           // 0.1 mm
+    uint16_t sum1h;             // 0.1 mm
+    uint16_t sum24h;            // 0.1 mm
+    uint8_t valid;
+};
+
+struct __attribute__((packed)) CompactRoom {
+    char name[16];              // NUL-terminated
+    int16_t temperature;        // 0.1 °C
+    uint16_t co2;               // ppm, 0 = no sensor
+    uint8_t humidity;           // %
+    uint8_t temperatureTrend;   // COMPACT_TREND_*
+    uint8_t valid;
+};
+
+struct __attribute__((packed)) CompactDayTime {
+    uint8_t hour;               // 6, 12 or 18 (local time), 0 = empty
+    int8_t temperature;         // °C (forecast temperatures are whole degrees)
+    uint8_t symbolCode;         // WeatherCondition (weather_symbols.h)
+    uint8_t precipitation;      // 0.1 mm in the following hour
+};
+
+struct __attribute__((packed)) CompactDay {
+    uint16_t dateOffset;        // Local midnight, minutes after baseDate
+    int8_t tempMin;             // °C
+    int8_t tempMax;             // °C
+    uint8_t symbolCode;         // Dominant WeatherCondition of the day
+    uint16_t precipSum;         // 0.1 mm
+    uint8_t windSpeedMax;       // km/h
+    uint8_t windDirection;      // 2° steps
+    CompactDayTime times[3];    // 06:00, 12:00, 18:00
+    uint8_t valid;
+};
+
+struct __attribute__((packed)) CompactForecast {
+    uint32_t baseDate;          // Local midnight of day 0 (UTC epoch)
+    int16_t currentTemp;        // "Current" point, 0.1 °C
+    uint8_t currentCode;
+    uint8_t currentValid;
+    CompactDay days[4];
+};
+
+struct __attribute__((packed)) CompactDashboard {
+    uint32_t timestamp;         // Netatmo measurement time (UTC epoch)
+    CompactIndoor indoor;
+    CompactOutdoor outdoor;
+    CompactWind wind;
+    CompactRain rain;
+    uint8_t roomCount;
+    CompactRoom rooms[COMPACT_MAX_ROOMS];
+    CompactForecast forecast;
+    char stationName[32];       // NUL-terminated
+};
+
+// Scalar conversions shared by the display and the hub
+
+inline int16_t compactDeci(float value) {
+    float scaled = value * 10.0f + (value < 0 ? -0.5f : 0.5f);
+    if (scaled <= -32768.0f) return INT16_MIN;
+    if (scaled >= 32767.0f) return INT16_MAX;
+    return (int16_t)scaled;
+}
+
+inline uint16_t compactDeciUnsigned(float value) {
+    if (value <= 0) return 0;
+    float scaled = value * 10.0f + 0.5f;
+    return scaled >= 65535.0f ? UINT16_MAX : (uint16_t)scaled;
+}
+
+inline float compactFromDeci(int32_t deci) {
+    return deci / 10.0f;
+}
+
+// Minutes (rounded) from one epoch to a later one, COMPACT_NO_TIME if either is 0
+inline uint16_t compactMinutes(uint32_t from, uint32_t to) {
+    if (from == 0 || to == 0) return COMPACT_NO_TIME;
+    if (to <= from) return 0;
+    uint32_t minutes = (to - from + 30) / 60;
+    return minutes >= COMPACT_NO_TIME ? COMPACT_NO_TIME - 1 : (uint16_t)minutes;
+}
+
+inline uint32_t compactAgeToEpoch(uint32_t timestamp, uint16_t age) {
+    return (age == COMPACT_NO_TIME || timestamp == 0) ? 0 : timestamp - (uint32_t)age * 60;
+}
+
+inline uint32_t compactOffsetToEpoch(uint32_t base, uint16_t offset) {
+    return (offset == COMPACT_NO_TIME || base == 0) ? 0 : base + (uint32_t)offset * 60;
+}
+
+#endif  // COMPACT_DATA_H
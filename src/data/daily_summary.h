@@ -0,0 +1,122 @@
+#ifndef DAILY_SUMMARY_H
+#define DAILY_SUMMARY_H
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "compact_data.h"
+#include "hourly_series.h"
+#include "weather_symbols.h"
+
+// Daily summaries from the hourly series: the one aggregation used by the
+// display (ForecastAggregator) and the hub (MetnoSource). Plain C++ like
+// compact_data.h; the caller supplies its local-time functions.
+class DailySummary {
+public:
+    // Local time of the caller (LocalTime on the display, libc on the hub)
+    struct Clock {
+        time_t (*startOfDay)(time_t utc);   // UTC instant of local midnight
+        uint8_t (*hour)(time_t utc);        // Local hour 0-23
+    };
+
+    // Fill days, day-time slots and current conditions for the 4 local days
+    // from the one containing now. False if the series has no points from
+    // today on (too old to use).
+    static bool build(const HourlySeries& series, time_t now, const Clock& clock,
+                      CompactForecast& forecast) {
+        // Local midnights of the 4 days and the end of the last one. Noon of a
+        // day plus 24 h is always inside the next day, even on 23/25 h DST days.
+        time_t dayStart[5];
+        dayStart[0] = clock.startOfDay(now);
+        for (int day = 1; day < 5; day++) {
+            dayStart[day] = clock.startOfDay(dayStart[day - 1] + 36 * 3600);
+        }
+
+        if (series.count == 0 || (time_t)series.timeAt(series.count - 1) < dayStart[0]) {
+            return false;
+        }
+
+        memset(&forecast, 0, sizeof(forecast));
+        forecast.baseDate = (uint32_t)dayStart[0];
+
+        int timeIdx[4] = {0};
+        int precipSum[4] = {0};
+        int symbolCount[4][WEATHER_CONDITION_COUNT] = {{0}};  // Occurrences of each condition per day
+
+        for (int day = 0; day < 4; day++) {
+            CompactDay& summary = forecast.days[day];
+            summary.dateOffset = compactMinutes(forecast.baseDate, (uint32_t)dayStart[day]);
+            summary.tempMin = 127;   // Start with max values
+            summary.tempMax = -128;
+        }
+
+        for (uint8_t i = 0; i < series.count; i++) {
+            time_t entryTime = series.timeAt(i);
+
+            // Series is chronological: stop after the last needed day
+            if (entryTime >= dayStart[4]) break;
+            if (entryTime < dayStart[0]) continue;
+
+            int day = 0;
+            while (entryTime >= dayStart[day + 1]) day++;
+            CompactDay& summary = forecast.days[day];
+
+            // Min/max temperature (whole degrees, truncated)
+            int8_t temp = (int8_t)(series.temperature[i] / 10);
+            if (temp < summary.tempMin) summary.tempMin = temp;
+            if (temp > summary.tempMax) summary.tempMax = temp;
+
+            if (series.windSpeed[i] > summary.windSpeedMax) {
+                summary.windSpeedMax = series.windSpeed[i];
+                summary.windDirection = series.windDirection[i];
+            }
+
+            // Precipitation (0.1 mm) and symbol of the following hour
+            precipSum[day] += series.precipitation[i];
+            uint8_t code = WEATHER_CLOUDY;
+            if (series.symbol[i] != HOURLY_NO_SYMBOL) {
+                code = series.symbol[i];
+                symbolCount[day][dayCondition(code)]++;  // Daily icon is always a day icon
+            }
+
+            // Day-time data points (06:00, 12:00, 18:00)
+            uint8_t entryHour = clock.hour(entryTime);
+            if ((entryHour == 6 || entryHour == 12 || entryHour == 18) && timeIdx[day] < 3) {
+                CompactDayTime& slot = summary.times[timeIdx[day]++];
+                slot.hour = entryHour;
+                slot.temperature = temp;
+                slot.symbolCode = code;
+                slot.precipitation = series.precipitation[i];
+            }
+        }
+
+        for (int day = 0; day < 4; day++) {
+            CompactDay& summary = forecast.days[day];
+            summary.precipSum = (uint16_t)(precipSum[day] > 65535 ? 65535 : precipSum[day]);
+
+            // Dominant symbol for the day (most frequent)
+            int maxCount = 0;
+            summary.symbolCode = WEATHER_CLOUDY;
+            for (int i = 0; i < WEATHER_CONDITION_COUNT; i++) {
+                if (symbolCount[day][i] > maxCount) {
+                    maxCount = symbolCount[day][i];
+                    summary.symbolCode = i;
+                }
+            }
+
+            summary.valid = (summary.tempMin < 127 && summary.tempMax > -128);
+        }
+
+        // "Current" point: first day-time slot of today
+        const CompactDay& today = forecast.days[0];
+        if (today.valid && today.times[0].temperature != 0) {
+            forecast.currentTemp = today.times[0].temperature * 10;
+            forecast.currentCode = today.symbolCode;
+            forecast.currentValid = 1;
+        }
+
+        return true;
+    }
+};
+
+#endif  // DAILY_SUMMARY_H
@@ -0,0 +1,77 @@
+#include "flash_wear.h"
+#include <LittleFS.h>
+#include <esp_partition.h>
+#include "state_store.h"
+#include "../power/sleep_manager.h"
+
+#define FLASH_BLOCK_SIZE 4096  // LittleFS block = flash sector
+
+// This wake, updated from any task
+static uint32_t bytesWritten = 0;
+static uint32_t blocksErased = 0;
+static uint32_t filesWritten = 0;
+
+// LittleFS uses a data partition of subtype "spiffs"; NVS and OTA writes are not counted
+static bool isFilesystem(const esp_partition_t* partition) {
+    return partition && partition->type == ESP_PARTITION_TYPE_DATA &&
+           partition->subtype == ESP_PARTITION_SUBTYPE_DATA_SPIFFS;
+}
+
+extern "C" {
+esp_err_t __real_esp_partition_write(const esp_partition_t* partition, size_t dst_offset,
+                                     const void* src, size_t size);
+esp_err_t __real_esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+
+esp_err_t __wrap_esp_partition_write(const esp_partition_t* partition, size_t dst_offset,
+                                     const void* src, size_t size) {
+    if (isFilesystem(partition)) {
+        __atomic_add_fetch(&bytesWritten, size, __ATOMIC_RELAXED);
+    }
+    return __real_esp_partition_write(partition, dst_offset, src, size);
+}
+
+esp_err_t __wrap_esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (isFilesystem(partition)) {
+        __atomic_add_fetch(&blocksErased, (size + FLASH_BLOCK_SIZE - 1) / FLASH_BLOCK_SIZE, __ATOMIC_RELAXED);
+    }
+    return __real_esp_partition_erase_range(partition, offset, size);
+}
+}
+
+void FlashWear::fileWritten() {
+    __atomic_add_fetch(&filesWritten, 1, __ATOMIC_RELAXED);
+}
+
+void FlashWear::endWake(WearState& totals) {
+    uint32_t bytes = __atomic_exchange_n(&bytesWritten, 0, __ATOMIC_RELAXED);
+    uint32_t erases = __atomic_exchange_n(&blocksErased, 0, __ATOMIC_RELAXED);
+    uint32_t files = __atomic_exchange_n(&filesWritten, 0, __ATOMIC_RELAXED);
+
+    time_t now = SleepManager::getEpoch();
+    if (totals.since == 0 || now < (time_t)totals.since) {
+        memset(&totals, 0, sizeof(totals));
+        totals.since = (uint32_t)now;
+    }
+    totals.wakes++;
+    totals.bytes += bytes;
+    totals.erases += erases;
+    totals.files += files;
+
+    ESP_LOGI("wear", "This wake: %lu bytes, %lu blocks erased, %lu files", (unsigned long)bytes,
+             (unsigned long)erases, (unsigned long)files);
+    ESP_LOGI("wear", "Per wake: %.0f bytes, %.2f blocks erased, %.1f files (%lu wakes)",
+             (double)totals.bytes / totals.wakes, (double)totals.erases / totals.wakes,
+             (double)totals.files / totals.wakes, (unsigned long)totals.wakes);
+
+    // Projection needs a day of history to be meaningful
+    float days = (now - (time_t)totals.since) / 86400.0f;
+    if (days < 1.0f || totals.erases == 0) {
+        return;
+    }
+
+    float blocks = LittleFS.totalBytes() / (float)FLASH_BLOCK_SIZE;
+    float erasesPerDay = totals.erases / days;
+    float lifetimeYears = blocks * FLASH_ENDURANCE_CYCLES / erasesPerDay / 365.0f;
+    ESP_LOGI("wear", "%.0f block erases/day over %.0f blocks: projected lifetime %.0f years",
+             erasesPerDay, blocks, lifetimeYears);
+}
@@ -0,0 +1,28 @@
+#ifndef FLASH_WEAR_H
+#define FLASH_WEAR_H
+
+#include <Arduino.h>
+
+struct WearState;
+
+// Flash wear accounting for the LittleFS partition. Bytes programmed and
+// blocks erased are counted below LittleFS, at the partition driver
+// (linker --wrap of esp_partition_write / esp_partition_erase_range, see
+// platformio.ini), so they include LittleFS's own metadata and
+// copy-on-write overhead. Files written are counted by the callers.
+//
+// The totals are kept in the wake record (StateStore) and give the
+// projected partition lifetime, assuming LittleFS spreads erases evenly
+// over its blocks and FLASH_ENDURANCE_CYCLES per block.
+class FlashWear {
+public:
+    // Count one file (re)write
+    static void fileWritten();
+
+    // Add this wake's counters to the totals and log both with the
+    // projected lifetime (StateStore::commit, before the wake record is
+    // written; that last write is not counted)
+    static void endWake(WearState& totals);
+};
+
+#endif  // FLASH_WEAR_H
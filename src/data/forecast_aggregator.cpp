@@ -0,0 +1,34 @@
+#include "forecast_aggregator.h"
+#include "compact_codec.h"
+#include "daily_summary.h"
+#include "../time/local_time.h"
+
+static uint8_t localHour(time_t utc) {
+    return LocalTime::breakdown(utc).hour;
+}
+
+static const DailySummary::Clock LOCAL_CLOCK = {LocalTime::startOfDay, localHour};
+
+bool ForecastAggregator::aggregate(ForecastData& data, time_t now) {
+    CompactForecast summary;
+    if (!DailySummary::build(data.hourly, now, LOCAL_CLOCK, summary)) {
+        return false;
+    }
+    CompactCodec::unpackForecast(summary, data);
+
+    for (int day = 0; day < 4; day++) {
+        const DailyForecast& dailyForecast = data.days[day];
+        if (dailyForecast.valid) {
+            int hours = 0;
+            while (hours < 3 && dailyForecast.times[hours].hour != 0) hours++;
+            ESP_LOGI("meteo", "Day %d: %d/%d°C, precip: %dmm, wind: %dkm/h, symbol: %d, hours: %d",
+                    day, dailyForecast.tempMin, dailyForecast.tempMax,
+                    dailyForecast.precipSum / 10, dailyForecast.windSpeedMax,
+                    dailyForecast.symbolCode, hours);
+        } else {
+            ESP_LOGW("meteo", "Day %d: No valid data", day);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,17 @@
+#ifndef FORECAST_AGGREGATOR_H
+#define FORECAST_AGGREGATOR_H
+
+#include <Arduino.h>
+#include "weather_data.h"
+
+// Daily summaries from the hourly series, shared by the forecast providers.
+// The aggregation itself is DailySummary (daily_summary.h), shared with the hub.
+class ForecastAggregator {
+public:
+    // Derive days, day-time slots and current conditions from data.hourly
+    // for the local day containing now. False if the series has no points
+    // from today on (too old to use).
+    static bool aggregate(ForecastData& data, time_t now);
+};
+
+#endif  // FORECAST_AGGREGATOR_H
@@ -0,0 +1,375 @@
+#include "history_log.h"
+#include "state_store.h"
+#include "flash_wear.h"
+#include "../time/local_time.h"
+
+// Segment sizes: about 4 KB per segment, 8 segments per log
+//   raw      256 x 16 B, 2048 wakes (~15 days at 11 min)
+//   hourly   128 x 28 B, 1024 hours (~42 days)
+//   daily     64 x 28 B, 512 days
+#define HISTORY_SEGMENTS 8
+
+RingLog::RingLog(const char* dir, uint16_t recordSize, uint16_t segmentRecords, uint8_t maxSegments)
+    : dir(dir), recordSize(recordSize), segmentRecords(segmentRecords),
+      maxSegments(maxSegments > RING_LOG_MAX_SEGMENTS ? RING_LOG_MAX_SEGMENTS : maxSegments),
+      scanned(false), sealed(false), firstSeq(0), segments(0), lastTime(0), cachedSeq(UINT32_MAX) {
+}
+
+void RingLog::segmentPath(uint32_t seq, char* path, size_t size) {
+    snprintf(path, size, "%s/%s/%08lu", HISTORY_DIR, dir, (unsigned long)seq);
+}
+
+// Find the segment range and record counts from the directory listing
+void RingLog::scan() {
+    scanned = true;
+    sealed = false;
+    firstSeq = 0;
+    segments = 0;
+    lastTime = 0;
+
+    char path[32];
+    snprintf(path, sizeof(path), "%s/%s", HISTORY_DIR, dir);
+    if (!LittleFS.exists(path)) {
+        LittleFS.mkdir(HISTORY_DIR);
+        LittleFS.mkdir(path);
+        return;
+    }
+
+    // Sequence numbers and sizes of all segment files
+    const int maxFiles = RING_LOG_MAX_SEGMENTS * 2;
+    uint32_t seqs[maxFiles];
+    uint32_t sizes[maxFiles];
+    int files = 0;
+    uint32_t newest = 0;
+
+    File directory = LittleFS.open(path);
+    for (File file = directory.openNextFile(); file && files < maxFiles; file = directory.openNextFile()) {
+        const char* name = strrchr(file.name(), '/');
+        name = name ? name + 1 : file.name();
+        seqs[files] = strtoul(name, nullptr, 10);
+        sizes[files] = file.size();
+        if (seqs[files] > newest) newest = seqs[files];
+        files++;
+        file.close();
+    }
+    directory.close();
+
+    if (files == 0) {
+        return;
+    }
+
+    // Keep the newest maxSegments sequence numbers, delete anything older
+    firstSeq = newest >= maxSegments ? newest - maxSegments + 1 : 0;
+    segments = newest - firstSeq + 1;
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < files; i++) {
+        if (seqs[i] < firstSeq) {
+            char old[40];
+            segmentPath(seqs[i], old, sizeof(old));
+            LittleFS.remove(old);
+            continue;
+        }
+        counts[seqs[i] - firstSeq] = sizes[i] / recordSize;
+        if (seqs[i] == newest && sizes[i] % recordSize != 0) {
+            sealed = true;  // Torn write: continue in a new segment
+        }
+    }
+
+    size_t total = count();
+    if (total > 0) {
+        readTime(total - 1, lastTime);
+    }
+}
+
+size_t RingLog::count() {
+    if (!scanned) scan();
+
+    size_t total = 0;
+    for (uint8_t s = 0; s < segments; s++) {
+        total += counts[s];
+    }
+    return total;
+}
+
+bool RingLog::append(const void* record) {
+    if (!scanned) scan();
+
+    uint32_t time;
+    memcpy(&time, record, sizeof(time));
+    if (segments > 0 && time <= lastTime) {
+        return false;
+    }
+
+    closeCached();
+
+    // Start a new segment when the newest one is full, dropping the oldest
+    if (segments == 0 || sealed || counts[segments - 1] >= segmentRecords) {
+        if (segments == maxSegments) {
+            char old[40];
+            segmentPath(firstSeq, old, sizeof(old));
+            LittleFS.remove(old);
+            memmove(counts, counts + 1, (segments - 1) * sizeof(counts[0]));
+            firstSeq++;
+            segments--;
+        }
+        counts[segments++] = 0;
+        sealed = false;
+    }
+
+    char path[40];
+    segmentPath(firstSeq + segments - 1, path, sizeof(path));
+    FlashWear::fileWritten();
+    File file = LittleFS.open(path, "a");
+    if (!file) {
+        ESP_LOGE("history", "Failed to open %s", path);
+        return false;
+    }
+
+    size_t written = file.write((const uint8_t*)record, recordSize);
+    file.close();
+
+    if (written != recordSize) {
+        ESP_LOGE("history", "Failed to append to %s", path);
+        scanned = false;  // Re-read the sizes next time
+        return false;
+    }
+
+    counts[segments - 1]++;
+    lastTime = time;
+    return true;
+}
+
+bool RingLog::locate(size_t index, uint32_t& seq, size_t& offset) {
+    for (uint8_t s = 0; s < segments; s++) {
+        if (index < counts[s]) {
+            seq = firstSeq + s;
+            offset = index * recordSize;
+            return true;
+        }
+        index -= counts[s];
+    }
+    return false;
+}
+
+bool RingLog::read(size_t index, void* record) {
+    if (!scanned) scan();
+
+    uint32_t seq;
+    size_t offset;
+    if (!locate(index, seq, offset)) {
+        return false;
+    }
+
+    // Reads during a query mostly hit the same segment: keep it open
+    if (seq != cachedSeq || !cachedFile) {
+        closeCached();
+        char path[40];
+        segmentPath(seq, path, sizeof(path));
+        cachedFile = LittleFS.open(path, "r");
+        if (!cachedFile) {
+            return false;
+        }
+        cachedSeq = seq;
+    }
+
+    return cachedFile.seek(offset) && cachedFile.read((uint8_t*)record, recordSize) == recordSize;
+}
+
+bool RingLog::readTime(size_t index, uint32_t& time) {
+    uint8_t buffer[64];
+    if (recordSize > sizeof(buffer) || !read(index, buffer)) {
+        return false;
+    }
+    memcpy(&time, buffer, sizeof(time));
+    return true;
+}
+
+size_t RingLog::lowerBound(uint32_t t) {
+    size_t low = 0;
+    size_t high = count();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        uint32_t time;
+        if (!readTime(mid, time)) {
+            return high;
+        }
+        if (time < t) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t RingLog::query(uint32_t from, uint32_t to, void* out, size_t max) {
+    size_t total = count();
+    size_t found = 0;
+    uint8_t* dest = (uint8_t*)out;
+
+    for (size_t i = lowerBound(from); i < total && found < max; i++) {
+        if (!read(i, dest + found * recordSize)) {
+            break;
+        }
+        uint32_t time;
+        memcpy(&time, dest + found * recordSize, sizeof(time));
+        if (time >= to) {
+            break;
+        }
+        found++;
+    }
+
+    closeCached();
+    return found;
+}
+
+void RingLog::closeCached() {
+    if (cachedFile) {
+        cachedFile.close();
+    }
+    cachedSeq = UINT32_MAX;
+}
+
+RingLog& History::rawLog() {
+    static RingLog log("raw", sizeof(HistoryRecord), 256, HISTORY_SEGMENTS);
+    return log;
+}
+
+RingLog& History::hourlyLog() {
+    static RingLog log("hour", sizeof(HistoryRollup), 128, HISTORY_SEGMENTS);
+    return log;
+}
+
+RingLog& History::dailyLog() {
+    static RingLog log("day", sizeof(HistoryRollup), 64, HISTORY_SEGMENTS);
+    return log;
+}
+
+void History::record(const DashboardData& data) {
+    const WeatherData& weather = data.weather;
+    if (weather.timestamp == 0) {
+        return;
+    }
+
+    HistoryRecord record;
+    memset(&record, 0, sizeof(record));
+    record.time = weather.timestamp;
+    record.indoorTemp = weather.indoor.valid ? compactDeci(weather.indoor.temperature) : HISTORY_NO_TEMP;
+    record.outdoorTemp = weather.outdoor.valid ? compactDeci(weather.outdoor.temperature) : HISTORY_NO_TEMP;
+    if (weather.indoor.valid) {
+        record.co2 = weather.indoor.co2;
+        record.pressure = weather.indoor.pressure;
+        record.indoorHumidity = weather.indoor.humidity;
+    }
+    if (weather.outdoor.valid) {
+        record.outdoorHumidity = weather.outdoor.humidity;
+    }
+    record.batteryMv = data.batteryVoltage > UINT16_MAX ? UINT16_MAX : data.batteryVoltage;
+
+    if (!rawLog().append(&record)) {
+        ESP_LOGD("history", "Measurement %lu already recorded", (unsigned long)record.time);
+        return;
+    }
+
+    // Roll up the hour / local day once a record from the next one arrives
+    HistoryState& state = StateStore::state().history;
+    uint32_t hour = record.time - record.time % 3600;
+    if (state.hour.start != hour) {
+        flush(state.hour, hourlyLog());
+        state.hour.start = hour;
+    }
+    accumulate(state.hour, record);
+
+    uint32_t day = (uint32_t)LocalTime::startOfDay(record.time);
+    if (state.day.start != day) {
+        flush(state.day, dailyLog());
+        state.day.start = day;
+    }
+    accumulate(state.day, record);
+
+    ESP_LOGI("history", "Recorded %lu (%u raw records)", (unsigned long)record.time,
+             (unsigned)rawLog().count());
+}
+
+void History::accumulate(RollupAccumulator& acc, const HistoryRecord& record) {
+    if (acc.count == 0) {
+        uint32_t start = acc.start;
+        memset(&acc, 0, sizeof(acc));
+        acc.start = start;
+        acc.indoorMin = INT16_MAX;
+        acc.indoorMax = INT16_MIN;
+        acc.outdoorMin = INT16_MAX;
+        acc.outdoorMax = INT16_MIN;
+        acc.batteryMin = UINT16_MAX;
+    }
+    acc.count++;
+
+    if (record.indoorTemp != HISTORY_NO_TEMP) {
+        acc.indoorCount++;
+        acc.indoorSum += record.indoorTemp;
+        if (record.indoorTemp < acc.indoorMin) acc.indoorMin = record.indoorTemp;
+        if (record.indoorTemp > acc.indoorMax) acc.indoorMax = record.indoorTemp;
+        acc.co2Sum += record.co2;
+        if (record.co2 > acc.co2Max) acc.co2Max = record.co2;
+        acc.pressureSum += record.pressure;
+        acc.indoorHumiditySum += record.indoorHumidity;
+    }
+
+    if (record.outdoorTemp != HISTORY_NO_TEMP) {
+        acc.outdoorCount++;
+        acc.outdoorSum += record.outdoorTemp;
+        if (record.outdoorTemp < acc.outdoorMin) acc.outdoorMin = record.outdoorTemp;
+        if (record.outdoorTemp > acc.outdoorMax) acc.outdoorMax = record.outdoorTemp;
+        acc.outdoorHumiditySum += record.outdoorHumidity;
+    }
+
+    if (record.batteryMv > 0 && record.batteryMv < acc.batteryMin) {
+        acc.batteryMin = record.batteryMv;
+    }
+}
+
+// Rounded average, HISTORY_NO_TEMP without samples
+static int16_t averageTemp(int32_t sum, uint16_t count) {
+    if (count == 0) return HISTORY_NO_TEMP;
+    return (int16_t)((sum + (sum < 0 ? -(int32_t)count / 2 : (int32_t)count / 2)) / (int32_t)count);
+}
+
+void History::flush(RollupAccumulator& acc, RingLog& log) {
+    if (acc.start != 0 && acc.count > 0) {
+        HistoryRollup rollup;
+        memset(&rollup, 0, sizeof(rollup));
+        rollup.time = acc.start;
+        rollup.count = acc.count;
+        rollup.indoorAvg = averageTemp(acc.indoorSum, acc.indoorCount);
+        rollup.indoorMin = acc.indoorCount ? acc.indoorMin : HISTORY_NO_TEMP;
+        rollup.indoorMax = acc.indoorCount ? acc.indoorMax : HISTORY_NO_TEMP;
+        rollup.outdoorAvg = averageTemp(acc.outdoorSum, acc.outdoorCount);
+        rollup.outdoorMin = acc.outdoorCount ? acc.outdoorMin : HISTORY_NO_TEMP;
+        rollup.outdoorMax = acc.outdoorCount ? acc.outdoorMax : HISTORY_NO_TEMP;
+        if (acc.indoorCount > 0) {
+            rollup.co2Avg = (acc.co2Sum + acc.indoorCount / 2) / acc.indoorCount;
+            rollup.co2Max = acc.co2Max;
+            rollup.pressureAvg = (acc.pressureSum + acc.indoorCount / 2) / acc.indoorCount;
+            rollup.indoorHumidityAvg = (acc.indoorHumiditySum + acc.indoorCount / 2) / acc.indoorCount;
+        }
+        if (acc.outdoorCount > 0) {
+            rollup.outdoorHumidityAvg = (acc.outdoorHumiditySum + acc.outdoorCount / 2) / acc.outdoorCount;
+        }
+        rollup.batteryMin = acc.batteryMin == UINT16_MAX ? 0 : acc.batteryMin;
+
+        log.append(&rollup);
+    }
+    memset(&acc, 0, sizeof(acc));
+}
+
+size_t History::queryRaw(uint32_t from, uint32_t to, HistoryRecord* out, size_t max) {
+    return rawLog().query(from, to, out, max);
+}
+
+size_t History::queryHourly(uint32_t from, uint32_t to, HistoryRollup* out, size_t max) {
+    return hourlyLog().query(from, to, out, max);
+}
+
+size_t History::queryDaily(uint32_t from, uint32_t to, HistoryRollup* out, size_t max) {
+    return dailyLog().query(from, to, out, max);
+}
@@ -0,0 +1,136 @@
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "weather_data.h"
+#include "compact_data.h"
+#include "../config.h"
+
+// Local measurement history: one HistoryRecord per wake with fresh data,
+// rolled up into hourly and daily HistoryRollups.
+//
+// Each log is an append-only ring of segment files under HISTORY_DIR
+// ("<log>/<sequence>"). Records are only ever appended; when the newest
+// segment is full a new one is started and the oldest deleted, so LittleFS
+// spreads the writes over the partition. Records are ordered by time, and
+// queries binary-search it (O(log n) record reads).
+
+#define HISTORY_NO_TEMP INT16_MIN   // Temperature not available
+
+// Raw record of one wake (16 bytes)
+struct __attribute__((packed)) HistoryRecord {
+    uint32_t time;              // Netatmo measurement time (UTC epoch)
+    int16_t indoorTemp;         // 0.1 °C
+    int16_t outdoorTemp;        // 0.1 °C
+    uint16_t co2;               // ppm, 0 = none
+    uint16_t pressure;          // mbar, 0 = none
+    uint16_t batteryMv;
+    uint8_t indoorHumidity;     // %
+    uint8_t outdoorHumidity;    // %
+};
+
+// Summary of one hour or local day (28 bytes)
+struct __attribute__((packed)) HistoryRollup {
+    uint32_t time;              // Period start (UTC epoch)
+    uint16_t count;             // Raw records in the period
+    int16_t indoorAvg;          // 0.1 °C
+    int16_t indoorMin;
+    int16_t indoorMax;
+    int16_t outdoorAvg;
+    int16_t outdoorMin;
+    int16_t outdoorMax;
+    uint16_t co2Avg;            // ppm
+    uint16_t co2Max;
+    uint16_t pressureAvg;       // mbar
+    uint16_t batteryMin;        // mV
+    uint8_t indoorHumidityAvg;  // %
+    uint8_t outdoorHumidityAvg;
+};
+
+// Rollup being built, persisted in the state store between wakes
+struct __attribute__((packed)) RollupAccumulator {
+    uint32_t start;             // Period start, 0 = empty
+    uint16_t count;
+    uint16_t indoorCount;
+    uint16_t outdoorCount;
+    int32_t indoorSum;
+    int16_t indoorMin;
+    int16_t indoorMax;
+    int32_t outdoorSum;
+    int16_t outdoorMin;
+    int16_t outdoorMax;
+    uint32_t co2Sum;
+    uint16_t co2Max;
+    uint32_t pressureSum;
+    uint16_t batteryMin;
+    uint32_t indoorHumiditySum;
+    uint32_t outdoorHumiditySum;
+};
+
+#define RING_LOG_MAX_SEGMENTS 16
+
+// Ring of fixed-size records (the first 4 bytes of each are its UTC time)
+class RingLog {
+public:
+    RingLog(const char* dir, uint16_t recordSize, uint16_t segmentRecords, uint8_t maxSegments);
+
+    // Append a record; false if it is not newer than the last one
+    bool append(const void* record);
+
+    // Number of stored records
+    size_t count();
+
+    // Read record index (0 = oldest)
+    bool read(size_t index, void* record);
+
+    // Index of the first record with time >= t (count() if there is none)
+    size_t lowerBound(uint32_t t);
+
+    // Copy up to max records with from <= time < to, oldest first
+    size_t query(uint32_t from, uint32_t to, void* out, size_t max);
+
+private:
+    const char* dir;
+    uint16_t recordSize;
+    uint16_t segmentRecords;
+    uint8_t maxSegments;
+
+    bool scanned;
+    bool sealed;                                // Newest segment ends in a torn record
+    uint32_t firstSeq;                          // Sequence number of segment 0
+    uint8_t segments;                           // Segments on flash
+    uint16_t counts[RING_LOG_MAX_SEGMENTS];     // Records per segment
+    uint32_t lastTime;                          // Time of the newest record
+
+    File cachedFile;                            // Open segment for reads
+    uint32_t cachedSeq;
+
+    void scan();
+    void segmentPath(uint32_t seq, char* path, size_t size);
+    bool locate(size_t index, uint32_t& seq, size_t& offset);
+    bool readTime(size_t index, uint32_t& time);
+    void closeCached();
+};
+
+class History {
+public:
+    // Append this wake's readings (skipped if the Netatmo timestamp did not
+    // change) and flush hourly/daily rollups whose period ended
+    static void record(const DashboardData& data);
+
+    // Time-range queries (from <= time < to), oldest first; return the count
+    static size_t queryRaw(uint32_t from, uint32_t to, HistoryRecord* out, size_t max);
+    static size_t queryHourly(uint32_t from, uint32_t to, HistoryRollup* out, size_t max);
+    static size_t queryDaily(uint32_t from, uint32_t to, HistoryRollup* out, size_t max);
+
+private:
+    static RingLog& rawLog();
+    static RingLog& hourlyLog();
+    static RingLog& dailyLog();
+
+    static void accumulate(RollupAccumulator& acc, const HistoryRecord& record);
+    static void flush(RollupAccumulator& acc, RingLog& log);
+};
+
+#endif  // HISTORY_LOG_H
@@ -0,0 +1,64 @@
+#ifndef HOURLY_SERIES_H
+#define HOURLY_SERIES_H
+
+#include <stdint.h>
+
+// Number of met.no timeseries points kept (hourly for ~60 h, then 6-hourly)
+#define HOURLY_SERIES_CAPACITY 96
+// Points are kept up to this many hours after local midnight of the fetch
+// day: the 4 displayed days plus one, so a day rollover without a refetch
+// still has four days to show
+#define HOURLY_SERIES_HORIZON_H 120
+
+#define HOURLY_NO_SYMBOL 0xFF  // Point has no next_1_hours block
+
+// Compact struct-of-arrays copy of the met.no timeseries, filled while
+// parsing and persisted to flash. Daily summaries, the 06/12/18 slots and
+// the hourly chart are derived from it, so a 304, an unexpired forecast or
+// a new day does not need the ~50 KB response again.
+//
+// Fixed point: temperature in 0.1 °C, precipitation in 0.1 mm, wind in
+// km/h, direction in 2° steps. Times are hours after baseEpoch.
+struct HourlySeries {
+    uint32_t baseEpoch;                                 // UTC, first point
+    uint8_t count;
+    uint8_t hourOffset[HOURLY_SERIES_CAPACITY];         // Hours after baseEpoch
+    int16_t temperature[HOURLY_SERIES_CAPACITY];        // 0.1 °C
+    uint8_t precipitation[HOURLY_SERIES_CAPACITY];      // 0.1 mm, next hour
+    uint8_t windSpeed[HOURLY_SERIES_CAPACITY];          // km/h
+    uint8_t windDirection[HOURLY_SERIES_CAPACITY];      // 2° steps
+    uint8_t symbol[HOURLY_SERIES_CAPACITY];             // WeatherCondition or HOURLY_NO_SYMBOL
+
+    HourlySeries() : baseEpoch(0), count(0) {}
+
+    void clear() {
+        baseEpoch = 0;
+        count = 0;
+    }
+
+    uint32_t timeAt(uint8_t i) const {
+        return baseEpoch + (uint32_t)hourOffset[i] * 3600;
+    }
+
+    // Append a point (times must be increasing). False when full or out of range.
+    bool append(uint32_t epoch, float tempC, float precipMm, float windMs,
+                uint16_t windDeg, uint8_t symbolCode) {
+        if (count >= HOURLY_SERIES_CAPACITY) return false;
+        if (count == 0) baseEpoch = epoch;
+        if (epoch < baseEpoch || (epoch - baseEpoch) / 3600 > 255) return false;
+
+        hourOffset[count] = (uint8_t)((epoch - baseEpoch) / 3600);
+        temperature[count] = (int16_t)(tempC * 10.0f + (tempC < 0 ? -0.5f : 0.5f));
+        precipitation[count] = precipMm <= 0 ? 0
+                             : precipMm >= 25.5f ? 255
+                             : (uint8_t)(precipMm * 10.0f + 0.5f);
+        float windKmh = windMs * 3.6f;
+        windSpeed[count] = windKmh >= 255.0f ? 255 : (uint8_t)windKmh;
+        windDirection[count] = (uint8_t)((windDeg % 360) / 2);
+        symbol[count] = symbolCode;
+        count++;
+        return true;
+    }
+};
+
+#endif  // HOURLY_SERIES_H
@@ -0,0 +1,34 @@
+#ifndef HUB_PROTOCOL_H
+#define HUB_PROTOCOL_H
+
+#include <stdint.h>
+#include "compact_data.h"
+
+// Wire format between the LAN hub daemon (hub/) and the display.
+// Plain C++ (no Arduino) so both sides compile the same header.
+//
+// The display opens a TCP connection, sends a HubRequest and reads a
+// HubFrameHeader followed by header.length bytes of CompactDashboard
+// (compact_data.h). The hub closes the connection afterwards. All fields are
+// little-endian (ESP32 and x86/ARM Linux hosts), structs are packed.
+
+#define HUB_MAGIC 0x4248574EUL  // "NWHB"
+#define HUB_PROTOCOL_VERSION 3  // 2: fixed-point payload, 3: extra rooms
+#define HUB_DEFAULT_PORT 8377
+
+struct __attribute__((packed)) HubRequest {
+    uint32_t magic;             // HUB_MAGIC
+    uint16_t version;           // HUB_PROTOCOL_VERSION
+    uint16_t reserved;
+};
+
+struct __attribute__((packed)) HubFrameHeader {
+    uint32_t magic;             // HUB_MAGIC
+    uint16_t version;           // HUB_PROTOCOL_VERSION
+    uint16_t reserved;
+    uint32_t length;            // Payload bytes following the header
+    uint32_t crc;               // CRC-32 of the payload
+    uint32_t serverTime;        // Hub clock (UTC epoch) when the frame was sent
+};
+
+#endif  // HUB_PROTOCOL_H
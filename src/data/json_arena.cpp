@@ -0,0 +1,144 @@
+#include "json_arena.h"
+#include <esp_heap_caps.h>
+
+// Header in front of every arena block (keeps payloads 8-byte aligned)
+struct ArenaBlock {
+    uint32_t size;     // Payload size requested
+    uint32_t prev;     // Offset of the previous block header
+    uint32_t freed;    // Deallocated, but not yet popped off the top
+    uint32_t reserved;
+};
+
+static const uint32_t NO_BLOCK = UINT32_MAX;
+
+static size_t alignSize(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+JsonArena::JsonArena()
+    : buffer(nullptr), capacity(0), top(0), lastBlock(NO_BLOCK), liveBlocks(0),
+      peak(0), phasePeak(0), heapFallbacks(0), bufferFailed(false) {
+}
+
+JsonArena* JsonArena::instance() {
+    static JsonArena arena;
+    return &arena;
+}
+
+bool JsonArena::ensureBuffer() {
+    if (buffer != nullptr) return true;
+    if (bufferFailed) return false;
+
+    buffer = (uint8_t*)heap_caps_malloc(JSON_ARENA_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buffer == nullptr) {
+        bufferFailed = true;
+        ESP_LOGW("arena", "PSRAM arena allocation failed, JSON uses internal heap");
+        return false;
+    }
+
+    capacity = JSON_ARENA_SIZE;
+    ESP_LOGI("arena", "JSON arena: %u bytes in PSRAM", (unsigned)capacity);
+    return true;
+}
+
+bool JsonArena::owns(const void* ptr) const {
+    return buffer != nullptr && ptr >= buffer && ptr < buffer + capacity;
+}
+
+void* JsonArena::allocate(size_t size) {
+    size_t needed = sizeof(ArenaBlock) + alignSize(size);
+
+    if (!ensureBuffer() || top + needed > capacity) {
+        heapFallbacks++;
+        return malloc(size);
+    }
+
+    ArenaBlock* block = (ArenaBlock*)(buffer + top);
+    block->size = size;
+    block->prev = lastBlock;
+    block->freed = 0;
+
+    lastBlock = top;
+    top += needed;
+    liveBlocks++;
+
+    if (top > phasePeak) phasePeak = top;
+    if (top > peak) peak = top;
+
+    return block + 1;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (ptr == nullptr) return;
+
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+
+    ArenaBlock* block = (ArenaBlock*)ptr - 1;
+    block->freed = 1;
+    liveBlocks--;
+
+    if (liveBlocks == 0) {
+        top = 0;
+        lastBlock = NO_BLOCK;
+    } else {
+        popFreedBlocks();
+    }
+}
+
+void JsonArena::popFreedBlocks() {
+    while (lastBlock != NO_BLOCK) {
+        ArenaBlock* block = (ArenaBlock*)(buffer + lastBlock);
+        if (!block->freed) break;
+        top = lastBlock;
+        lastBlock = block->prev;
+    }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+    if (ptr == nullptr) return allocate(newSize);
+
+    if (!owns(ptr)) {
+        return realloc(ptr, newSize);
+    }
+
+    ArenaBlock* block = (ArenaBlock*)ptr - 1;
+    size_t offset = (uint8_t*)block - buffer;
+
+    // Newest block: grow or shrink in place
+    if (offset == lastBlock) {
+        size_t newTop = offset + sizeof(ArenaBlock) + alignSize(newSize);
+        if (newTop <= capacity) {
+            block->size = newSize;
+            top = newTop;
+            if (top > phasePeak) phasePeak = top;
+            if (top > peak) peak = top;
+            return ptr;
+        }
+    } else if (newSize <= block->size) {
+        block->size = newSize;
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (moved == nullptr) return nullptr;
+    memcpy(moved, ptr, min((size_t)block->size, newSize));
+    deallocate(ptr);
+    return moved;
+}
+
+void JsonArena::endPhase(const char* name) {
+    ESP_LOGI("arena", "%s: peak %u bytes (overall %u / %u), %u live blocks, %u heap fallbacks",
+            name, (unsigned)phasePeak, (unsigned)peak, (unsigned)capacity,
+            (unsigned)liveBlocks, (unsigned)heapFallbacks);
+
+    if (liveBlocks == 0) {
+        top = 0;
+        lastBlock = NO_BLOCK;
+    } else {
+        ESP_LOGW("arena", "%s: %u blocks still live, arena not reset", name, (unsigned)liveBlocks);
+    }
+    phasePeak = top;
+}
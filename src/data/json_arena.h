@@ -0,0 +1,51 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+// Bump allocator for JsonDocument, backed by one PSRAM buffer per wake.
+// Keeps DOM allocations out of the internal SRAM the TLS stack needs.
+//
+// Blocks are only reclaimed from the top: freeing the newest block rewinds
+// the arena, and it rewinds completely once no block is live. Allocations
+// that do not fit (or when PSRAM is missing) fall back to the regular heap.
+// Not thread-safe: only use it from the main task.
+//
+// Usage: JsonDocument doc(JsonArena::instance());
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    // Shared arena instance (buffer is allocated on first use)
+    static JsonArena* instance();
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+    // Log the high-water mark of the phase that just ended and rewind the
+    // arena if no document is alive anymore
+    void endPhase(const char* name);
+
+    // Highest arena usage since boot (bytes)
+    size_t peakBytes() const { return peak; }
+
+private:
+    JsonArena();
+
+    bool ensureBuffer();
+    bool owns(const void* ptr) const;
+    void popFreedBlocks();
+
+    uint8_t* buffer;
+    size_t capacity;
+    size_t top;              // Offset of the first free byte
+    uint32_t lastBlock;      // Offset of the newest block header
+    uint32_t liveBlocks;     // Arena blocks not yet deallocated
+    size_t peak;             // High-water mark since boot
+    size_t phasePeak;        // High-water mark of the current phase
+    uint32_t heapFallbacks;  // Allocations that went to the regular heap
+    bool bufferFailed;       // PSRAM allocation failed, don't retry
+};
+
+#endif  // JSON_ARENA_H
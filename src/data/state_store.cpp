@@ -0,0 +1,255 @@
+#include "state_store.h"
+#include <LittleFS.h>
+#include "crc32.h"
+#include "flash_wear.h"
+
+// Header of each slot file, followed by the record
+struct __attribute__((packed)) SlotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;          // Bytes of record that follow (older firmware may write fewer)
+    uint32_t sequence;      // Incremented by every write, the higher valid slot is current
+    uint32_t crc;           // CRC-32 of the record bytes
+};
+
+// A record kept in two files written alternately: a torn or corrupt write
+// only ever hits the older slot, the current one stays readable
+struct SlotFile {
+    const char* paths[2];
+    uint32_t magic;
+    uint16_t version;
+    bool valid;             // current/sequence/crc describe a slot on flash
+    uint8_t current;
+    uint32_t sequence;
+    uint32_t crc;
+    uint16_t size;
+};
+
+static const uint32_t STATE_MAGIC = 0x54415453;  // "STAT"
+static const uint16_t STATE_VERSION = 2;          // 1: single STATE_LEGACY_FILE
+static const uint32_t WAKE_MAGIC = 0x454B4157;   // "WAKE"
+static const uint16_t WAKE_VERSION = 1;
+
+// Legacy STATE_LEGACY_FILE header (no sequence number)
+struct __attribute__((packed)) LegacyStateHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t crc;
+};
+
+static PersistentState persistentState;
+static VolatileState wakeState;
+
+// The wake record is small enough for LittleFS to keep inline in the
+// directory entry, so no data block is erased for it
+static SlotFile stateSlots = {{STATE_SLOT_A, STATE_SLOT_B}, STATE_MAGIC, STATE_VERSION, false, 0, 0, 0, 0};
+static SlotFile wakeSlots = {{WAKE_SLOT_A, WAKE_SLOT_B}, WAKE_MAGIC, WAKE_VERSION, false, 0, 0, 0, 0};
+
+PersistentState& StateStore::state() {
+    return persistentState;
+}
+
+VolatileState& StateStore::volatileState() {
+    return wakeState;
+}
+
+static bool readSlotHeader(const char* path, const SlotFile& slots, size_t maxSize, SlotHeader& header) {
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              header.magic == slots.magic && header.version == slots.version &&
+              header.size > 0 && header.size <= maxSize;
+    file.close();
+    return ok;
+}
+
+static bool readSlotData(const char* path, const SlotHeader& header, void* data) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    bool ok = file.seek(sizeof(header)) &&
+              file.read((uint8_t*)data, header.size) == header.size &&
+              crc32(data, header.size) == header.crc;
+    file.close();
+    return ok;
+}
+
+// Load the newest valid slot into data (size bytes, a shorter record leaves the tail zeroed)
+static bool loadSlots(SlotFile& slots, void* data, size_t size) {
+    slots.valid = false;
+
+    SlotHeader headers[2];
+    bool present[2];
+    for (int i = 0; i < 2; i++) {
+        present[i] = readSlotHeader(slots.paths[i], slots, size, headers[i]);
+    }
+
+    // Newest first; fall back to the other slot if its data is torn
+    int order[2] = {0, 1};
+    if (present[1] && (!present[0] || headers[1].sequence > headers[0].sequence)) {
+        order[0] = 1;
+        order[1] = 0;
+    }
+
+    for (int i : order) {
+        if (!present[i]) {
+            continue;
+        }
+        memset(data, 0, size);
+        if (readSlotData(slots.paths[i], headers[i], data)) {
+            slots.valid = true;
+            slots.current = i;
+            slots.sequence = headers[i].sequence;
+            slots.crc = headers[i].crc;
+            slots.size = headers[i].size;
+            return true;
+        }
+        ESP_LOGW("state", "%s corrupt, trying the other slot", slots.paths[i]);
+    }
+
+    memset(data, 0, size);
+    return false;
+}
+
+// Write data to the slot that is not current
+static bool writeSlot(SlotFile& slots, const void* data, size_t size) {
+    uint8_t next = slots.valid ? 1 - slots.current : 0;
+    SlotHeader header = {slots.magic, slots.version, (uint16_t)size, slots.sequence + 1, crc32(data, size)};
+
+    File file = LittleFS.open(slots.paths[next], "w");
+    if (!file) {
+        ESP_LOGE("state", "Failed to open %s for writing", slots.paths[next]);
+        return false;
+    }
+    size_t written = file.write((const uint8_t*)&header, sizeof(header));
+    written += file.write((const uint8_t*)data, size);
+    file.close();
+
+    if (written != sizeof(header) + size) {
+        ESP_LOGE("state", "Failed to write %s", slots.paths[next]);
+        return false;
+    }
+
+    slots.valid = true;
+    slots.current = next;
+    slots.sequence = header.sequence;
+    slots.crc = header.crc;
+    slots.size = header.size;
+    return true;
+}
+
+// Single STATE_LEGACY_FILE of earlier firmware, deleted once the slots are written
+static bool loadLegacyState() {
+    File file = LittleFS.open(STATE_LEGACY_FILE, "r");
+    if (!file) {
+        return false;
+    }
+
+    LegacyStateHeader header;
+    bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              header.magic == STATE_MAGIC && header.version == 1 &&
+              header.size > 0 && header.size <= sizeof(persistentState) &&
+              file.read((uint8_t*)&persistentState, header.size) == header.size &&
+              crc32(&persistentState, header.size) == header.crc;
+    file.close();
+
+    if (!ok) {
+        memset(&persistentState, 0, sizeof(persistentState));
+    }
+    return ok;
+}
+
+// WAKE_LEGACY_FILE of earlier firmware: VolatileState (or a prefix) + CRC-32
+static bool loadLegacyWakeRecord() {
+    File file = LittleFS.open(WAKE_LEGACY_FILE, "r");
+    if (!file) {
+        return false;
+    }
+
+    VolatileState record;
+    memset(&record, 0, sizeof(record));
+    size_t length = file.size() - sizeof(uint32_t);
+    uint32_t crc = 0;
+    bool ok = file.size() > sizeof(uint32_t) && length <= sizeof(record) &&
+              file.read((uint8_t*)&record, length) == length &&
+              file.read((uint8_t*)&crc, sizeof(crc)) == sizeof(crc) &&
+              crc32(&record, length) == crc;
+    file.close();
+
+    if (ok) {
+        wakeState = record;
+    }
+    return ok;
+}
+
+bool StateStore::load() {
+    bool ok = loadState();
+
+    if (!loadSlots(wakeSlots, &wakeState, sizeof(wakeState)) &&
+        !(LittleFS.exists(WAKE_LEGACY_FILE) && loadLegacyWakeRecord())) {
+        // Older firmware kept the per-wake values in the state
+        const SleepState& sleep = persistentState.sleep;
+        wakeState.wakeCount = sleep.wakeCount;
+        wakeState.lastUpdateSuccess = sleep.lastUpdateSuccess;
+        wakeState.lastSyncEpoch = sleep.lastSyncEpoch;
+    }
+
+    return ok;
+}
+
+bool StateStore::loadState() {
+    memset(&wakeState, 0, sizeof(wakeState));
+
+    if (loadSlots(stateSlots, &persistentState, sizeof(persistentState))) {
+        ESP_LOGI("state", "State loaded from %s (#%lu, %u of %u bytes)", stateSlots.paths[stateSlots.current],
+                 (unsigned long)stateSlots.sequence, stateSlots.size, (unsigned)sizeof(persistentState));
+        return true;
+    }
+
+    if (LittleFS.exists(STATE_LEGACY_FILE) && loadLegacyState()) {
+        ESP_LOGI("state", "Legacy state file loaded");
+        return true;
+    }
+
+    ESP_LOGI("state", "No valid state");
+    return false;
+}
+
+bool StateStore::commitWake() {
+    bool ok = commit();
+
+    FlashWear::fileWritten();
+    FlashWear::endWake(wakeState.wear);
+    return writeSlot(wakeSlots, &wakeState, sizeof(wakeState)) && ok;
+}
+
+bool StateStore::commit() {
+    // A shorter slot from older firmware is rewritten with the new sections
+    uint32_t crc = crc32(&persistentState, sizeof(persistentState));
+    if (stateSlots.valid && stateSlots.size == sizeof(persistentState) && crc == stateSlots.crc) {
+        ESP_LOGI("state", "State unchanged, not rewritten");
+        return true;
+    }
+
+    FlashWear::fileWritten();
+    if (!writeSlot(stateSlots, &persistentState, sizeof(persistentState))) {
+        return false;
+    }
+
+    // The slots supersede the single file of older firmware
+    if (LittleFS.exists(STATE_LEGACY_FILE)) {
+        LittleFS.remove(STATE_LEGACY_FILE);
+        LittleFS.remove(WAKE_LEGACY_FILE);
+    }
+
+    ESP_LOGI("state", "State saved to %s (#%lu, %u bytes)", stateSlots.paths[stateSlots.current],
+             (unsigned long)stateSlots.sequence, (unsigned)sizeof(persistentState));
+    return true;
+}
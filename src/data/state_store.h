@@ -0,0 +1,130 @@
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include <Arduino.h>
+#include "compact_data.h"
+#include "history_log.h"
+#include "../config.h"
+
+// Everything that has to survive M5.shutdown() (RTC memory does not) in one
+// binary record. Modules work on the in-memory copy; commitWake() writes it
+// once at the end of the wake.
+//
+// The record alternates between two slot files (STATE_SLOT_A/B), each with a
+// sequence number and CRC-32. A write only replaces the older slot, so a
+// brown-out during shutdown leaves the previous state readable; load() takes
+// the newest slot that checks out.
+//
+// commit() skips the rewrite when the CRC-32 of the state matches the
+// current slot. Values that change on every wake are kept out of it, in the
+// tiny VolatileState record (WAKE_SLOT_A/B, same scheme), so a wake without
+// new data only rewrites that.
+//
+// The hourly forecast series stays in HOURLY_FILE: it is only rewritten
+// when the forecast changed.
+
+#define STATE_TOKEN_SIZE 128  // Netatmo tokens are "<user id>|<hex>" (~57 characters)
+
+// SleepManager: RTC drift model
+struct __attribute__((packed)) SleepState {
+    uint8_t wakeCount;          // Moved to VolatileState, only read when migrating
+    uint8_t lastUpdateSuccess;  // "
+    uint32_t lastSyncEpoch;     // "
+    uint32_t rtcSetEpoch;       // Last time the hardware RTC was written
+    float driftPpm;             // Estimated RTC drift (> 0: RTC runs slow)
+    uint8_t driftSamples;       // Agreeing samples behind driftPpm
+};
+
+// NetatmoClient: OAuth2 tokens
+struct __attribute__((packed)) TokenState {
+    uint32_t configHash;                    // CRC-32 of the NETATMO_REFRESH_TOKEN they derive from
+    char refreshToken[STATE_TOKEN_SIZE];    // Latest (rotated) refresh token
+    char accessToken[STATE_TOKEN_SIZE];
+    uint32_t accessExpiry;                  // UTC epoch
+};
+
+// Forecast provider: validators for conditional requests
+struct __attribute__((packed)) ValidatorState {
+    char etag[48];
+    char lastModified[32];
+    uint32_t expires;           // Expires header, UTC epoch
+};
+
+// DataCache: last dashboard for offline wakes
+struct __attribute__((packed)) CachedDashboard {
+    uint32_t savedAt;           // UTC epoch when saved, 0 = empty
+    CompactDashboard data;
+};
+
+// History: hourly and daily rollups in progress
+struct __attribute__((packed)) HistoryState {
+    RollupAccumulator hour;
+    RollupAccumulator day;
+};
+
+// SleepManager: weight of the RTC drift model (SleepState)
+struct __attribute__((packed)) DriftState {
+    uint32_t baselineSec;       // RTC run time behind driftPpm, 0 = not recorded
+};
+
+// DataCache: measurement times of modules in the cached dashboard that were
+// carried over from an earlier fetch (0 = measured with the cached data)
+struct __attribute__((packed)) CachedModuleTimes {
+    uint32_t indoor;
+    uint32_t outdoor;
+    uint32_t wind;
+    uint32_t rain;
+};
+
+// New sections go at the end: a shorter file from older firmware still loads,
+// the missing sections start zeroed
+struct __attribute__((packed)) PersistentState {
+    SleepState sleep;
+    TokenState tokens;
+    ValidatorState forecast;
+    CachedDashboard cache;
+    HistoryState history;
+    DriftState drift;
+    CachedModuleTimes cacheModules;
+};
+
+// FlashWear: LittleFS write totals
+struct __attribute__((packed)) WearState {
+    uint32_t since;             // UTC epoch the totals start, 0 = not started
+    uint32_t wakes;
+    uint64_t bytes;             // Bytes programmed
+    uint32_t erases;            // 4 KB blocks erased
+    uint32_t files;             // Files written
+};
+
+// Values updated on every wake (WAKE_SLOT_A/B). New fields go at the end: a
+// shorter record from older firmware still loads, the rest starts zeroed.
+struct __attribute__((packed)) VolatileState {
+    uint8_t wakeCount;          // SleepManager
+    uint8_t lastUpdateSuccess;
+    uint32_t lastSyncEpoch;     // Last time the clock was confirmed by a time source
+    WearState wear;
+};
+
+class StateStore {
+public:
+    // In-memory state (zeroed until load())
+    static PersistentState& state();
+    static VolatileState& volatileState();
+
+    // Read the newest valid state slot (LittleFS must be mounted). False if
+    // there is none; the state is zeroed then and modules fall back to their
+    // legacy files. Also reads the wake record (taken from the state if missing).
+    static bool load();
+
+    // Write the state to the older slot (next sequence number, CRC-32) if it changed
+    static bool commit();
+
+    // commit(), then the wake record with the flash wear totals; once at the end of the wake
+    static bool commitWake();
+
+private:
+    static bool loadState();
+};
+
+#endif  // STATE_STORE_H
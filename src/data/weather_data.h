@@ -2,6 +2,8 @@
 #define WEATHER_DATA_H
 
 #include <Arduino.h>
+#include "weather_symbols.h"
+#include "hourly_series.h"
 
 // Trend indicators
 enum class Trend {
@@ -25,12 +27,13 @@ struct IndoorData {
     float maxTemp;              // Daily maximum
     unsigned long dateMinTemp;  // Unix timestamp
     unsigned long dateMaxTemp;  // Unix timestamp
+    unsigned long cachedTime;   // Measurement time of a reading carried over from the cache, 0 = current
     bool valid;                 // Data validity flag
 
     IndoorData() : temperature(0), humidity(0), co2(0), noise(0), pressure(0),
                    temperatureTrend(Trend::UNKNOWN), pressureTrend(Trend::UNKNOWN),
                    co2Trend(Trend::UNKNOWN), minTemp(0), maxTemp(0),
-                   dateMinTemp(0), dateMaxTemp(0), valid(false) {}
+                   dateMinTemp(0), dateMaxTemp(0), cachedTime(0), valid(false) {}
 };
 
 // Outdoor climate data (from outdoor Netatmo module)
@@ -42,10 +45,11 @@ struct OutdoorData {
     float maxTemp;              // Daily maximum
     unsigned long dateMinTemp;  // Unix timestamp
     unsigned long dateMaxTemp;  // Unix timestamp
+    unsigned long cachedTime;   // Measurement time of a reading carried over from the cache, 0 = current
     bool valid;                 // Data validity flag
 
     OutdoorData() : temperature(0), humidity(0), temperatureTrend(Trend::UNKNOWN),
-                    minTemp(0), maxTemp(0), dateMinTemp(0), dateMaxTemp(0), valid(false) {}
+                    minTemp(0), maxTemp(0), dateMinTemp(0), dateMaxTemp(0), cachedTime(0), valid(false) {}
 };
 
 // Wind data (from wind Netatmo module)
@@ -56,10 +60,11 @@ struct WindData {
     uint16_t gustAngle;         // degrees
     uint16_t maxWindStrength;   // Daily max km/h
     unsigned long dateMaxWind;  // Unix timestamp
+    unsigned long cachedTime;   // Measurement time of a reading carried over from the cache, 0 = current
     bool valid;                 // Data validity flag
 
     WindData() : strength(0), angle(0), gustStrength(0), gustAngle(0),
-                 maxWindStrength(0), dateMaxWind(0), valid(false) {}
+                 maxWindStrength(0), dateMaxWind(0), cachedTime(0), valid(false) {}
 };
 
 // Rain data (from rain Netatmo module)
@@ -67,9 +72,26 @@ struct RainData {
     float current;              // mm
     float sum1h;                // mm (last hour)
     float sum24h;               // mm (last 24 hours)
+    unsigned long cachedTime;   // Measurement time of a reading carried over from the cache, 0 = current
     bool valid;                 // Data validity flag
 
-    RainData() : current(0), sum1h(0), sum24h(0), valid(false) {}
+    RainData() : current(0), sum1h(0), sum24h(0), cachedTime(0), valid(false) {}
+};
+
+// Extra rooms shown besides the main indoor unit
+#define MAX_ROOMS 4
+
+// Additional room: an indoor module (NAModule4) or another station's base unit
+struct RoomData {
+    char name[16];              // Module or station name (truncated)
+    float temperature;          // °C
+    uint8_t humidity;           // %
+    uint16_t co2;               // ppm, 0 if the module has no sensor
+    Trend temperatureTrend;
+    bool valid;                 // Data validity flag
+
+    RoomData() : temperature(0), humidity(0), co2(0),
+                 temperatureTrend(Trend::UNKNOWN), valid(false) { name[0] = '\0'; }
 };
 
 // Complete Netatmo weather data
@@ -78,10 +100,13 @@ struct WeatherData {
     OutdoorData outdoor;
     WindData wind;
     RainData rain;
+    RoomData rooms[MAX_ROOMS];  // Extra rooms in response order
+    uint8_t roomCount;
+    uint8_t stationCount;       // Stations in the response
     unsigned long timestamp;    // Unix timestamp of last measurement
     String stationName;
 
-    WeatherData() : timestamp(0), stationName("") {}
+    WeatherData() : roomCount(0), stationCount(0), timestamp(0), stationName("") {}
 };
 
 // Forecast data point (from MeteoSwiss/Open-Meteo)
@@ -104,8 +129,8 @@ struct ForecastPoint {
 struct DayTimeForecast {
     uint8_t hour;              // 6, 12, or 18 (local time)
     int8_t temperature;        // °C
-    uint8_t symbolCode;        // Symbol code enum index (0=sunny, 1=partly_cloudy, 2=cloudy, 3=rain, 4=snow)
-    uint8_t precipitationMm;   // mm (0-255)
+    uint8_t symbolCode;        // WeatherCondition (weather_symbols.h)
+    uint8_t precipitationMm;   // 0.1 mm in the following hour
 
     DayTimeForecast() : hour(0), temperature(0), symbolCode(0), precipitationMm(0) {}
 };
@@ -118,8 +143,8 @@ struct DailyForecast {
     unsigned long date;        // Unix timestamp (midnight UTC)
     int8_t tempMin;            // °C
     int8_t tempMax;            // °C
-    uint8_t symbolCode;        // Dominant weather symbol for the day
-    uint8_t precipSum;         // Total precipitation 24h (mm)
+    uint8_t symbolCode;        // Dominant WeatherCondition for the day (day variant)
+    uint16_t precipSum;        // Total precipitation 24h (0.1 mm)
     uint8_t windSpeedMax;      // Max wind speed km/h
     uint16_t windDirection;    // Wind direction (degrees)
     DayTimeForecast times[3];  // 3 times per day: 06:00, 12:00, 18:00
@@ -132,9 +157,8 @@ struct DailyForecast {
 // Extended forecast data (met.no API)
 struct ForecastData {
     ForecastPoint current;      // Current conditions (for backward compatibility)
-    ForecastPoint forecast3h;   // +3 hours (deprecated, kept for compatibility)
-    ForecastPoint forecast6h;   // +6 hours (deprecated, kept for compatibility)
     DailyForecast days[4];      // 4-day forecast from met.no
+    HourlySeries hourly;        // met.no timeseries the above is derived from (empty via hub)
 
     ForecastData() {}
 };
@@ -148,8 +172,10 @@ struct DashboardData {
     unsigned long updateTime;   // Unix timestamp of dashboard update
     unsigned long nextWakeTime; // Unix timestamp of next scheduled wake
     bool isFallback;            // True if using fallback sleep interval
+    unsigned long cacheAge;     // Seconds since the shown data was cached, 0 = fetched this wake
 
-    DashboardData() : batteryVoltage(0), batteryPercent(0), updateTime(0), nextWakeTime(0), isFallback(false) {}
+    DashboardData() : batteryVoltage(0), batteryPercent(0), updateTime(0), nextWakeTime(0), isFallback(false),
+                      cacheAge(0) {}
 };
 
 // Helper function to convert trend string to enum
@@ -191,52 +217,65 @@ inline const char* getHumidityComfort(uint8_t humidity) {
 // Helper function to convert symbol code enum to icon name
 inline const char* getIconFromCode(uint8_t symbolCode) {
     switch (symbolCode) {
-        case 0: return "sunny";
-        case 1: return "partly_cloudy";
-        case 2: return "cloudy";
-        case 3: return "rain";
-        case 4: return "snow";
+        case WEATHER_SUNNY: return "sunny";
+        case WEATHER_PARTLY_CLOUDY: return "partly_cloudy";
+        case WEATHER_CLOUDY: return "cloudy";
+        case WEATHER_RAIN: return "rain";
+        case WEATHER_SNOW: return "snow";
+        case WEATHER_FOG: return "fog";
+        case WEATHER_SLEET: return "sleet";
+        case WEATHER_THUNDER: return "thunder";
+        case WEATHER_CLEAR_NIGHT: return "clear_night";
+        case WEATHER_PARTLY_CLOUDY_NIGHT: return "partly_cloudy_night";
         default: return "cloudy";
     }
 }
 
-// MeteoSwiss pictogram code to internal symbol code mapping
-// MeteoSwiss codes: 1-44 (see https://data.geo.admin.ch)
-// Internal codes: 0=sunny, 1=partly_cloudy, 2=cloudy, 3=rain, 4=snow
+// MeteoSwiss pictogram code to WeatherCondition mapping
+// MeteoSwiss codes: 1-44 (see https://data.geo.admin.ch), the app API adds
+// 100 for the night variant of a day pictogram
 inline uint8_t parseMeteoSwissPictogram(int pictogramCode) {
+    if (pictogramCode > 100) {
+        uint8_t day = parseMeteoSwissPictogram(pictogramCode - 100);
+        if (day == WEATHER_SUNNY) return WEATHER_CLEAR_NIGHT;
+        if (day == WEATHER_PARTLY_CLOUDY) return WEATHER_PARTLY_CLOUDY_NIGHT;
+        return day;
+    }
+
     // Sunny conditions (1-2)
-    if (pictogramCode == 1 || pictogramCode == 2) return 0;  // sunny
+    if (pictogramCode == 1 || pictogramCode == 2) return WEATHER_SUNNY;
 
-    // Partly cloudy / fair (3-5, 35 = night partly cloudy)
-    if (pictogramCode == 3 || pictogramCode == 4 || pictogramCode == 5 || pictogramCode == 35) return 1;  // partly_cloudy
+    // Partly cloudy / fair (3-5)
+    if (pictogramCode >= 3 && pictogramCode <= 5) return WEATHER_PARTLY_CLOUDY;
 
     // Cloudy (6-8)
-    if (pictogramCode >= 6 && pictogramCode <= 8) return 2;  // cloudy
+    if (pictogramCode >= 6 && pictogramCode <= 8) return WEATHER_CLOUDY;
 
     // Fog (9-11)
-    if (pictogramCode >= 9 && pictogramCode <= 11) return 2;  // cloudy (fog mapped to cloudy)
+    if (pictogramCode >= 9 && pictogramCode <= 11) return WEATHER_FOG;
 
     // Showers / light rain (12-14)
-    if (pictogramCode >= 12 && pictogramCode <= 14) return 3;  // rain
+    if (pictogramCode >= 12 && pictogramCode <= 14) return WEATHER_RAIN;
 
     // Thunderstorms (15-17)
-    if (pictogramCode >= 15 && pictogramCode <= 17) return 3;  // rain (thunder mapped to rain)
+    if (pictogramCode >= 15 && pictogramCode <= 17) return WEATHER_THUNDER;
 
     // Rain (18-21)
-    if (pictogramCode >= 18 && pictogramCode <= 21) return 3;  // rain
+    if (pictogramCode >= 18 && pictogramCode <= 21) return WEATHER_RAIN;
 
     // Snow (22-28)
-    if (pictogramCode >= 22 && pictogramCode <= 28) return 4;  // snow
+    if (pictogramCode >= 22 && pictogramCode <= 28) return WEATHER_SNOW;
 
     // Sleet / freezing rain (29-34)
-    if (pictogramCode >= 29 && pictogramCode <= 34) return 3;  // rain (sleet mapped to rain)
+    if (pictogramCode >= 29 && pictogramCode <= 34) return WEATHER_SLEET;
 
-    // Night variations (36-44) - map similarly
-    if (pictogramCode == 36 || pictogramCode == 37) return 0;  // clear night -> sunny
-    if (pictogramCode >= 38 && pictogramCode <= 40) return 3;  // night rain
-    if (pictogramCode >= 41 && pictogramCode <= 44) return 4;  // night snow
+    // Night variations (35-44)
+    if (pictogramCode == 35) return WEATHER_PARTLY_CLOUDY_NIGHT;
+    if (pictogramCode == 36 || pictogramCode == 37) return WEATHER_CLEAR_NIGHT;
+    if (pictogramCode >= 38 && pictogramCode <= 40) return WEATHER_RAIN;   // night rain
+    if (pictogramCode >= 41 && pictogramCode <= 44) return WEATHER_SNOW;   // night snow
 
-    return 2;  // Default: cloudy
+    return WEATHER_CLOUDY;
 }
 
 #endif  // WEATHER_DATA_H
@@ -0,0 +1,172 @@
+#ifndef WEATHER_SYMBOLS_H
+#define WEATHER_SYMBOLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Internal weather condition (symbolCode in the forecast structures).
+// Values 0-4 are the original five icons and keep their numbers, so cached
+// data and older hub frames stay valid.
+enum WeatherCondition : uint8_t {
+    WEATHER_SUNNY = 0,
+    WEATHER_PARTLY_CLOUDY = 1,
+    WEATHER_CLOUDY = 2,
+    WEATHER_RAIN = 3,
+    WEATHER_SNOW = 4,
+    WEATHER_FOG = 5,
+    WEATHER_SLEET = 6,
+    WEATHER_THUNDER = 7,
+    WEATHER_CLEAR_NIGHT = 8,
+    WEATHER_PARTLY_CLOUDY_NIGHT = 9,
+    WEATHER_CONDITION_COUNT
+};
+
+// Day counterpart of a night condition (for daily summaries)
+inline WeatherCondition dayCondition(uint8_t condition) {
+    if (condition == WEATHER_CLEAR_NIGHT) return WEATHER_SUNNY;
+    if (condition == WEATHER_PARTLY_CLOUDY_NIGHT) return WEATHER_PARTLY_CLOUDY;
+    return condition < WEATHER_CONDITION_COUNT ? (WeatherCondition)condition : WEATHER_CLOUDY;
+}
+
+// met.no symbol codes -> WeatherCondition through a perfect hash built at
+// compile time. Only the base name is hashed ("rainshowers" of
+// "rainshowers_night"); the hash loop stops at the '_' so the suffix is
+// read without a second scan. Plain C++ so the LAN hub shares the mapping.
+class MetnoSymbols {
+public:
+    // Unknown or missing symbols map to cloudy
+    static WeatherCondition parse(const char* symbol) {
+        if (!symbol) return WEATHER_CLOUDY;
+
+        size_t length = 0;
+        uint32_t slot = hashBase(symbol, TABLE.seed, &length) & (TABLE_SIZE - 1);
+        uint8_t index = TABLE.slots[slot];
+        if (index == EMPTY) return WEATHER_CLOUDY;
+
+        const Entry& entry = ENTRIES[index];
+        if (strncmp(entry.name, symbol, length) != 0 || entry.name[length] != '\0') {
+            return WEATHER_CLOUDY;
+        }
+
+        // "_night" turns clear/fair/partly cloudy into the moon icons;
+        // "_day" and "_polartwilight" keep the day icon
+        if (symbol[length] == '_' && symbol[length + 1] == 'n') {
+            if (entry.condition == WEATHER_SUNNY) return WEATHER_CLEAR_NIGHT;
+            if (entry.condition == WEATHER_PARTLY_CLOUDY) return WEATHER_PARTLY_CLOUDY_NIGHT;
+        }
+        return entry.condition;
+    }
+
+private:
+    struct Entry {
+        const char* name;
+        WeatherCondition condition;
+    };
+
+    // Full met.no legend (api.met.no/weatherapi/weathericon/2.0/legends).
+    // The "lights..." spellings are met.no's own; the regular spellings are
+    // accepted as well.
+    static constexpr Entry ENTRIES[] = {
+        {"clearsky", WEATHER_SUNNY},
+        {"fair", WEATHER_PARTLY_CLOUDY},
+        {"partlycloudy", WEATHER_PARTLY_CLOUDY},
+        {"cloudy", WEATHER_CLOUDY},
+        {"fog", WEATHER_FOG},
+
+        {"lightrainshowers", WEATHER_RAIN},
+        {"rainshowers", WEATHER_RAIN},
+        {"heavyrainshowers", WEATHER_RAIN},
+        {"lightrain", WEATHER_RAIN},
+        {"rain", WEATHER_RAIN},
+        {"heavyrain", WEATHER_RAIN},
+
+        {"lightsleetshowers", WEATHER_SLEET},
+        {"sleetshowers", WEATHER_SLEET},
+        {"heavysleetshowers", WEATHER_SLEET},
+        {"lightsleet", WEATHER_SLEET},
+        {"sleet", WEATHER_SLEET},
+        {"heavysleet", WEATHER_SLEET},
+
+        {"lightsnowshowers", WEATHER_SNOW},
+        {"snowshowers", WEATHER_SNOW},
+        {"heavysnowshowers", WEATHER_SNOW},
+        {"lightsnow", WEATHER_SNOW},
+        {"snow", WEATHER_SNOW},
+        {"heavysnow", WEATHER_SNOW},
+
+        {"lightrainshowersandthunder", WEATHER_THUNDER},
+        {"rainshowersandthunder", WEATHER_THUNDER},
+        {"heavyrainshowersandthunder", WEATHER_THUNDER},
+        {"lightssleetshowersandthunder", WEATHER_THUNDER},
+        {"lightsleetshowersandthunder", WEATHER_THUNDER},
+        {"sleetshowersandthunder", WEATHER_THUNDER},
+        {"heavysleetshowersandthunder", WEATHER_THUNDER},
+        {"lightssnowshowersandthunder", WEATHER_THUNDER},
+        {"lightsnowshowersandthunder", WEATHER_THUNDER},
+        {"snowshowersandthunder", WEATHER_THUNDER},
+        {"heavysnowshowersandthunder", WEATHER_THUNDER},
+        {"lightrainandthunder", WEATHER_THUNDER},
+        {"rainandthunder", WEATHER_THUNDER},
+        {"heavyrainandthunder", WEATHER_THUNDER},
+        {"lightsleetandthunder", WEATHER_THUNDER},
+        {"sleetandthunder", WEATHER_THUNDER},
+        {"heavysleetandthunder", WEATHER_THUNDER},
+        {"lightsnowandthunder", WEATHER_THUNDER},
+        {"snowandthunder", WEATHER_THUNDER},
+        {"heavysnowandthunder", WEATHER_THUNDER},
+    };
+
+    static constexpr size_t ENTRY_COUNT = sizeof(ENTRIES) / sizeof(ENTRIES[0]);
+    static constexpr size_t TABLE_SIZE = 1024;  // Power of two, ~4% load
+    static constexpr uint8_t EMPTY = 0xFF;
+
+    struct Table {
+        uint8_t slots[TABLE_SIZE];
+        uint32_t seed;
+    };
+
+    // FNV-1a over the base name (up to '_' or the end), seeded, with a final
+    // mix so the low bits used for the slot depend on every character
+    static constexpr uint32_t hashBase(const char* str, uint32_t seed, size_t* length = nullptr) {
+        uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+        size_t i = 0;
+        while (str[i] != '\0' && str[i] != '_') {
+            hash ^= (uint8_t)str[i];
+            hash *= 16777619u;
+            i++;
+        }
+        if (length) *length = i;
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6Bu;
+        hash ^= hash >> 13;
+        return hash;
+    }
+
+    // Try seeds until every entry lands in its own slot
+    static constexpr Table build() {
+        for (uint32_t seed = 1;; seed++) {
+            Table table = {};
+            for (size_t i = 0; i < TABLE_SIZE; i++) table.slots[i] = EMPTY;
+            table.seed = seed;
+
+            bool collision = false;
+            for (size_t i = 0; i < ENTRY_COUNT && !collision; i++) {
+                uint32_t slot = hashBase(ENTRIES[i].name, seed) & (TABLE_SIZE - 1);
+                if (table.slots[slot] != EMPTY) {
+                    collision = true;
+                } else {
+                    table.slots[slot] = (uint8_t)i;
+                }
+            }
+            if (!collision) return table;
+        }
+    }
+
+    static const Table TABLE;
+};
+
+// Defined after the class so build() is complete when it runs
+inline constexpr MetnoSymbols::Table MetnoSymbols::TABLE = MetnoSymbols::build();
+
+#endif  // WEATHER_SYMBOLS_H
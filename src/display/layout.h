@@ -28,8 +28,9 @@
 #define HUMID_CARD_HEIGHT 130       // Humidity cards
 #define AIR_QUALITY_CARD_HEIGHT 114 // CO2 card (inline "ppm" saves vertical space)
 #define PRESSURE_CARD_HEIGHT 114    // Pressure card (inline "hPa")
-#define FORECAST_CARD_HEIGHT 390    // 4-day forecast (compressed to fit battery)
+#define FORECAST_CARD_HEIGHT 390    // 3-day forecast + 24 h chart (compressed to fit battery)
 #define BATTERY_CARD_HEIGHT 55      // Battery card (slim bar)
+#define ROOMS_CARD_HEIGHT 98        // Extra rooms (only drawn if there are any)
 
 // Row positions (calculated)
 #define ROW1_Y (HEADER_HEIGHT + MARGIN)                             // 61
@@ -37,6 +38,7 @@
 #define ROW3_Y (ROW2_Y + HUMID_CARD_HEIGHT + CARD_SPACING)          // 403
 #define ROW4_Y (ROW3_Y + AIR_QUALITY_CARD_HEIGHT + CARD_SPACING)    // 509
 #define ROW5_Y (ROW4_Y + FORECAST_CARD_HEIGHT + CARD_SPACING)       // 795
+#define ROW6_Y (ROW5_Y + BATTERY_CARD_HEIGHT + CARD_SPACING)        // 856
 
 // Card internal layout - BALANCED spacing
 #define CARD_PADDING 12          // Padding from card border
@@ -71,7 +73,7 @@
 #define PRESSURE_Y ROW3_Y
 
 // ============================================================================
-// FULL-WIDTH: FORECAST + BATTERY
+// FULL-WIDTH: FORECAST + BATTERY + ROOMS
 // ============================================================================
 #define FORECAST_WIDGET_X MARGIN
 #define FORECAST_WIDGET_Y ROW4_Y
@@ -79,6 +81,9 @@
 #define BATTERY_X MARGIN
 #define BATTERY_Y ROW5_Y
 
+#define ROOMS_X MARGIN
+#define ROOMS_Y ROW6_Y
+
 // Forecast internal layout constants
 #define FORECAST_DAY_COL_X 10        // Day name column offset
 #define FORECAST_ICON_SIZE 48        // Forecast icon size (bigger)
@@ -88,6 +93,8 @@
 #define FORECAST_SLOT4_X 320         // Daily summary
 #define FORECAST_PRECIP_X 420        // Precipitation column offset
 #define FORECAST_RANGE_X 420         // Temp range column offset
+#define FORECAST_CHART_X 80          // 24 h chart plot area (last row)
+#define FORECAST_CHART_WIDTH 320
 #define FORECAST_TODAY_ICON_X 60     // "Heute" icon position
 #define FORECAST_TODAY_TEXT_X 130    // "Heute" text block position
 
@@ -1,14 +0,0 @@
-#ifndef LIBERATION_FONTS_H
-#define LIBERATION_FONTS_H
-
-#include <Arduino.h>
-
-// Liberation Sans Regular (342KB TTF)
-extern const unsigned char LiberationSans_Regular_ttf[];
-extern const unsigned int LiberationSans_Regular_ttf_len;
-
-// Liberation Sans Bold (346KB TTF)
-extern const unsigned char LiberationSans_Bold_ttf[];
-extern const unsigned int LiberationSans_Bold_ttf_len;
-
-#endif  // LIBERATION_FONTS_H
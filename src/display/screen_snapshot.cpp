@@ -0,0 +1,279 @@
+#include "screen_snapshot.h"
+#include <LittleFS.h>
+#include "../config.h"
+#include "../data/crc32.h"
+#include "../data/flash_wear.h"
+
+// Header of SNAPSHOT_FILE, followed by the encoded frame
+struct __attribute__((packed)) SnapshotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t width;
+    uint16_t height;
+    uint16_t reserved;
+    uint32_t rawSize;       // Frame buffer bytes (width * height / 2)
+    uint32_t crc;           // CRC-32 of the frame buffer
+};
+
+static const uint32_t SNAPSHOT_MAGIC = 0x50414E53;  // "SNAP"
+static const uint16_t SNAPSHOT_VERSION = 1;
+
+static const size_t RLE_MIN_RUN = 3;
+static const size_t RLE_MAX_RUN = 0x7FFF + RLE_MIN_RUN;
+static const size_t RLE_MAX_LITERAL = 128;
+
+// Buffered byte output to a file
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(File& file) : file(file), used(0), total(0), ok(true) {}
+
+    void put(uint8_t value) {
+        if (used == sizeof(buffer)) flush();
+        buffer[used++] = value;
+    }
+
+    void put(const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; i++) put(data[i]);
+    }
+
+    bool flush() {
+        if (used > 0 && file.write(buffer, used) != used) ok = false;
+        total += used;
+        used = 0;
+        return ok;
+    }
+
+    size_t written() const { return total + used; }
+
+private:
+    File& file;
+    uint8_t buffer[256];
+    size_t used;
+    size_t total;
+    bool ok;
+};
+
+// Buffered byte input from a file, -1 at the end
+class SnapshotReader {
+public:
+    explicit SnapshotReader(File& file) : file(file), length(0), pos(0) {}
+
+    int next() {
+        if (pos == length) {
+            length = file.read(buffer, sizeof(buffer));
+            pos = 0;
+            if (length == 0) return -1;
+        }
+        return buffer[pos++];
+    }
+
+private:
+    File& file;
+    uint8_t buffer[512];
+    size_t length;
+    size_t pos;
+};
+
+static void encodeLiterals(SnapshotWriter& out, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        size_t n = length < RLE_MAX_LITERAL ? length : RLE_MAX_LITERAL;
+        out.put((uint8_t)(n - 1));
+        out.put(data, n);
+        data += n;
+        length -= n;
+    }
+}
+
+static void encode(SnapshotWriter& out, const uint8_t* data, size_t size) {
+    size_t literalStart = 0;
+    size_t i = 0;
+    while (i < size) {
+        size_t run = 1;
+        while (i + run < size && run < RLE_MAX_RUN && data[i + run] == data[i]) run++;
+
+        if (run >= RLE_MIN_RUN) {
+            encodeLiterals(out, data + literalStart, i - literalStart);
+            size_t n = run - RLE_MIN_RUN;
+            out.put((uint8_t)(0x80 | (n >> 8)));
+            out.put((uint8_t)(n & 0xFF));
+            out.put(data[i]);
+            i += run;
+            literalStart = i;
+        } else {
+            i += run;
+        }
+    }
+    encodeLiterals(out, data + literalStart, size - literalStart);
+}
+
+// Decode into sink(offset, value); false if the data is short, long or corrupt
+template <typename Sink>
+static bool decode(File& file, size_t size, Sink sink) {
+    SnapshotReader in(file);
+    size_t offset = 0;
+
+    int control;
+    while ((control = in.next()) >= 0) {
+        if (control < 0x80) {
+            size_t n = control + 1;
+            if (offset + n > size) return false;
+            for (size_t i = 0; i < n; i++) {
+                int value = in.next();
+                if (value < 0) return false;
+                sink(offset++, (uint8_t)value);
+            }
+        } else {
+            int lo = in.next();
+            int value = in.next();
+            if (lo < 0 || value < 0) return false;
+            size_t n = (((size_t)(control & 0x7F) << 8) | lo) + RLE_MIN_RUN;
+            if (offset + n > size) return false;
+            for (size_t i = 0; i < n; i++) {
+                sink(offset++, (uint8_t)value);
+            }
+        }
+    }
+    return offset == size;
+}
+
+static uint8_t* frameOf(M5EPD_Canvas& canvas, size_t& size) {
+    size = (size_t)canvas.width() * canvas.height() / 2;  // 4bpp
+    return (uint8_t*)canvas.frameBuffer(1);
+}
+
+// Open SNAPSHOT_FILE and check that it matches the canvas
+static bool openSnapshot(M5EPD_Canvas& canvas, File& file, SnapshotHeader& header) {
+    if (!LittleFS.exists(SNAPSHOT_FILE)) {
+        return false;
+    }
+
+    file = LittleFS.open(SNAPSHOT_FILE, "r");
+    if (!file) {
+        return false;
+    }
+
+    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+        header.width != canvas.width() || header.height != canvas.height() ||
+        header.rawSize != (uint32_t)canvas.width() * canvas.height() / 2) {
+        ESP_LOGW("snapshot", "Snapshot does not match the canvas");
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool ScreenSnapshot::save(M5EPD_Canvas& canvas) {
+    size_t size;
+    uint8_t* frame = frameOf(canvas, size);
+    if (!frame) {
+        return false;
+    }
+
+    uint32_t crc = crc32(frame, size);
+
+    // Same screen as stored: nothing to write
+    File file;
+    SnapshotHeader header;
+    if (openSnapshot(canvas, file, header)) {
+        file.close();
+        if (header.crc == crc) {
+            ESP_LOGI("snapshot", "Screen unchanged, snapshot kept");
+            return true;
+        }
+    }
+
+    unsigned long start = millis();
+    header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, (uint16_t)canvas.width(), (uint16_t)canvas.height(), 0,
+              (uint32_t)size, crc};
+
+    // LittleFS commits the new contents on close, a power loss keeps the old file
+    FlashWear::fileWritten();
+    file = LittleFS.open(SNAPSHOT_FILE, "w");
+    if (!file) {
+        ESP_LOGE("snapshot", "Failed to open snapshot for writing");
+        return false;
+    }
+
+    SnapshotWriter out(file);
+    out.put((const uint8_t*)&header, sizeof(header));
+    encode(out, frame, size);
+    bool ok = out.flush();
+    file.close();
+
+    if (!ok) {
+        ESP_LOGE("snapshot", "Failed to write snapshot");
+        LittleFS.remove(SNAPSHOT_FILE);
+        return false;
+    }
+
+    ESP_LOGI("snapshot", "Snapshot saved: %u -> %u bytes in %lu ms",
+             (unsigned)size, (unsigned)out.written(), millis() - start);
+    return true;
+}
+
+bool ScreenSnapshot::restore(M5EPD_Canvas& canvas) {
+    size_t size;
+    uint8_t* frame = frameOf(canvas, size);
+    File file;
+    SnapshotHeader header;
+    if (!frame || !openSnapshot(canvas, file, header)) {
+        return false;
+    }
+
+    bool ok = decode(file, size, [frame](size_t offset, uint8_t value) { frame[offset] = value; });
+    file.close();
+
+    if (!ok || crc32(frame, size) != header.crc) {
+        ESP_LOGW("snapshot", "Snapshot corrupt");
+        memset(frame, 0, size);
+        return false;
+    }
+
+    ESP_LOGI("snapshot", "Snapshot restored");
+    return true;
+}
+
+bool ScreenSnapshot::changedArea(M5EPD_Canvas& canvas, ScreenArea& area) {
+    area = {0, 0, 0, 0};
+
+    size_t size;
+    uint8_t* frame = frameOf(canvas, size);
+    File file;
+    SnapshotHeader header;
+    if (!frame || !openSnapshot(canvas, file, header)) {
+        return false;
+    }
+
+    if (crc32(frame, size) == header.crc) {
+        file.close();
+        return true;
+    }
+
+    // Byte columns/rows (two pixels per byte) that differ
+    size_t rowBytes = canvas.width() / 2;
+    size_t minRow = SIZE_MAX, maxRow = 0, minCol = SIZE_MAX, maxCol = 0;
+    bool ok = decode(file, size, [&](size_t offset, uint8_t value) {
+        if (frame[offset] == value) return;
+        size_t row = offset / rowBytes;
+        size_t col = offset % rowBytes;
+        if (row < minRow) minRow = row;
+        if (row > maxRow) maxRow = row;
+        if (col < minCol) minCol = col;
+        if (col > maxCol) maxCol = col;
+    });
+    file.close();
+
+    if (!ok) {
+        ESP_LOGW("snapshot", "Snapshot corrupt");
+        return false;
+    }
+
+    if (minRow != SIZE_MAX) {
+        area.x = minCol * 2;
+        area.y = minRow;
+        area.w = (maxCol - minCol + 1) * 2;
+        area.h = maxRow - minRow + 1;
+    }
+    return true;
+}
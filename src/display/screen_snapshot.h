@@ -0,0 +1,39 @@
+#ifndef SCREEN_SNAPSHOT_H
+#define SCREEN_SNAPSHOT_H
+
+#include <M5EPD.h>
+
+// Run-length compressed copy of the last pushed canvas (SNAPSHOT_FILE).
+// The 4bpp dashboard is mostly white, so the 259 KB frame shrinks to a few
+// KB. Used to restore the last screen without network access after a cold
+// boot and as reference for finding the changed part of the next frame;
+// the file can also be pulled off the device for debugging.
+//
+// Encoding (byte-wise):
+//   0x00-0x7F n          n+1 literal bytes follow
+//   0x80-0xFF lo, value  run of (((n & 0x7F) << 8 | lo) + 3) times value
+
+// Screen rectangle in canvas pixels
+struct ScreenArea {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+
+    bool empty() const { return w == 0 || h == 0; }
+};
+
+class ScreenSnapshot {
+public:
+    // Store the canvas after pushCanvas(); skipped if it equals the snapshot
+    static bool save(M5EPD_Canvas& canvas);
+
+    // Load the snapshot into the canvas (same size only)
+    static bool restore(M5EPD_Canvas& canvas);
+
+    // Bounding box of the pixels that differ from the snapshot (empty if
+    // none); false if there is no usable snapshot
+    static bool changedArea(M5EPD_Canvas& canvas, ScreenArea& area);
+};
+
+#endif  // SCREEN_SNAPSHOT_H
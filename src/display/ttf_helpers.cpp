@@ -1,56 +1,73 @@
 #include "ttf_helpers.h"
-#include "liberation_fonts.h"
+#include "../data/assets.h"
+
+// TTF files in the assets partition (assets/fonts/)
+static const char* const FONT_FILES[] = {
+    "fonts/LiberationSans-Regular.ttf",  // FONT_REGULAR
+    "fonts/LiberationSans-Bold.ttf",     // FONT_BOLD
+};
 
 static LoadedFont currentFont = FONT_REGULAR;
+static bool fontLoaded = false;
+static bool fontsAvailable = false;
 
-void initTTFFonts(M5EPD_Canvas& canvas) {
-    // Load Regular font and create renders for common sizes (doubled)
-    canvas.loadFont(LiberationSans_Regular_ttf, LiberationSans_Regular_ttf_len);
-    canvas.createRender(24, 256);
-    canvas.createRender(28, 256);
-    canvas.createRender(36, 256);
-    canvas.createRender(48, 256);
-    canvas.createRender(64, 256);
+// Load a font and create renders for common sizes
+static bool loadFont(M5EPD_Canvas& canvas, LoadedFont font) {
+    size_t size;
+    const uint8_t* data = Assets::find(FONT_FILES[font], size);
+    if (!data) {
+        return false;
+    }
 
-    // Switch to Bold and create renders
-    canvas.unloadFont();
-    canvas.loadFont(LiberationSans_Bold_ttf, LiberationSans_Bold_ttf_len);
+    if (fontLoaded) {
+        canvas.unloadFont();
+    }
+    canvas.loadFont(data, size);
+    fontLoaded = true;
     canvas.createRender(24, 256);
     canvas.createRender(28, 256);
     canvas.createRender(36, 256);
     canvas.createRender(48, 256);
     canvas.createRender(64, 256);
-    currentFont = FONT_BOLD;
+    currentFont = font;
+    return true;
+}
+
+// Without the assets partition the built-in 8 px font is scaled instead
+static void setFallbackFont(M5EPD_Canvas& canvas, uint16_t size) {
+    canvas.setTextFont(1);
+    canvas.setTextSize(size >= 16 ? size / 8 : 1);
+}
+
+void initTTFFonts(M5EPD_Canvas& canvas) {
+    // Create renders for Regular, then switch to Bold and create its renders
+    fontsAvailable = loadFont(canvas, FONT_REGULAR) && loadFont(canvas, FONT_BOLD);
+    if (!fontsAvailable) {
+        ESP_LOGE("ttf", "Liberation Sans not available, using the built-in font");
+        return;
+    }
 
     ESP_LOGI("ttf", "Liberation Sans fonts initialized (regular + bold, 24/28/36/48/64pt)");
 }
 
 void setRegularFont(M5EPD_Canvas& canvas, uint16_t size) {
+    if (!fontsAvailable) {
+        setFallbackFont(canvas, size);
+        return;
+    }
     if (currentFont != FONT_REGULAR) {
-        canvas.unloadFont();
-        canvas.loadFont(LiberationSans_Regular_ttf, LiberationSans_Regular_ttf_len);
-        // Recreate renders after loading font
-        canvas.createRender(24, 256);
-        canvas.createRender(28, 256);
-        canvas.createRender(36, 256);
-        canvas.createRender(48, 256);
-        canvas.createRender(64, 256);
-        currentFont = FONT_REGULAR;
+        loadFont(canvas, FONT_REGULAR);
     }
     canvas.setTextSize(size);
 }
 
 void setBoldFont(M5EPD_Canvas& canvas, uint16_t size) {
+    if (!fontsAvailable) {
+        setFallbackFont(canvas, size);
+        return;
+    }
     if (currentFont != FONT_BOLD) {
-        canvas.unloadFont();
-        canvas.loadFont(LiberationSans_Bold_ttf, LiberationSans_Bold_ttf_len);
-        // Recreate renders after loading font
-        canvas.createRender(24, 256);
-        canvas.createRender(28, 256);
-        canvas.createRender(36, 256);
-        canvas.createRender(48, 256);
-        canvas.createRender(64, 256);
-        currentFont = FONT_BOLD;
+        loadFont(canvas, FONT_BOLD);
     }
     canvas.setTextSize(size);
 }
@@ -3,6 +3,7 @@
 #include "fonts.h"
 #include "icons.h"
 #include "../config.h"
+#include "../time/local_time.h"
 #include <time.h>
 
 // Helper to draw a card background + border (clears previous ghosting)
@@ -17,9 +18,20 @@ void formatTime(unsigned long timestamp, char* buffer, size_t bufferSize) {
         snprintf(buffer, bufferSize, "--:--");
         return;
     }
-    time_t t = timestamp;
-    struct tm* tm = localtime(&t);
-    snprintf(buffer, bufferSize, "%02d:%02d", tm->tm_hour, tm->tm_min);
+    CivilDateTime local = LocalTime::breakdown(timestamp);
+    snprintf(buffer, bufferSize, "%02d:%02d", local.hour, local.minute);
+}
+
+// Reading carried over from the cache (module missing from the last fetch):
+// its measurement time, drawn where the trend arrow would be
+static void drawCachedMarker(M5EPD_Canvas& display, int cardX, int cardY, unsigned long cachedTime) {
+    char timeStr[16];
+    formatTime(cachedTime, timeStr, sizeof(timeStr));
+    display.setTextDatum(TR_DATUM);
+    setRegularFont(display, 24);
+    display.drawString("Stand", cardX + CARD_WIDTH - 8, cardY + CARD_TREND_Y - 4);
+    display.drawString(timeStr, cardX + CARD_WIDTH - 8, cardY + CARD_TREND_Y + 20);
+    display.setTextDatum(TL_DATUM);
 }
 
 // Note: drawTemperature() function removed - TTF fonts support native ° symbol
@@ -78,6 +90,14 @@ void drawTrendArrow(M5EPD_Canvas& display, int x, int y, Trend trend) {
     }
 }
 
+// Small cloud used above precipitation icons (same shape as the rain/snow icons)
+static void drawPrecipCloud(M5EPD_Canvas& display, int cx, int cloudY, int size) {
+    display.fillCircle(cx - size / 8, cloudY, size / 9, 15);
+    display.fillCircle(cx, cloudY - size / 12, size / 8, 15);
+    display.fillCircle(cx + size / 8, cloudY, size / 9, 15);
+    display.fillRect(cx - size / 7, cloudY, size / 3.5, size / 9, 15);
+}
+
 void drawWeatherIcon(M5EPD_Canvas& display, int x, int y, const char* iconName, int size) {
     // Center point for the icon
     int cx = x + size / 2;
@@ -192,9 +212,69 @@ void drawWeatherIcon(M5EPD_Canvas& display, int x, int y, const char* iconName,
                            flakeX + flakeSize/1.5, flakeY - flakeSize/1.5, 15);
         }
     }
+    else if (strcmp(iconName, "fog") == 0) {
+        // Small cloud above three fog bands
+        drawPrecipCloud(display, cx, cy - size / 8, size);
+
+        for (int i = 0; i < 3; i++) {
+            int bandY = cy + size / 8 + i * (size / 10);
+            int inset = (i == 1) ? size / 10 : 0;  // Staggered middle band
+            display.fillRect(cx - size / 4 + inset, bandY, size / 2 - inset, 2, 15);
+        }
+    }
+    else if (strcmp(iconName, "sleet") == 0) {
+        // Cloud with alternating rain drops and snowflakes
+        drawPrecipCloud(display, cx, cy - size / 8, size);
+
+        int y = cy + size / 6;
+        int flakeSize = size / 14;
+        for (int i = 0; i < 4; i++) {
+            int x = cx - size / 5 + (i * size / 8);
+            if (i % 2 == 0) {
+                display.drawLine(x, y, x, y + size / 8, 15);
+                display.drawLine(x + 1, y, x + 1, y + size / 8, 15);
+            } else {
+                int fy = y + size / 16;
+                display.drawLine(x, fy - flakeSize, x, fy + flakeSize, 15);
+                display.drawLine(x - flakeSize, fy, x + flakeSize, fy, 15);
+            }
+        }
+    }
+    else if (strcmp(iconName, "thunder") == 0) {
+        // Cloud with a lightning bolt
+        drawPrecipCloud(display, cx, cy - size / 8, size);
+
+        int boltTop = cy + size / 12;
+        int boltMid = cy + size / 5;
+        int boltBottom = cy + size / 3;
+        display.fillTriangle(cx + size / 16, boltTop, cx - size / 10, boltMid + 1,
+                             cx + size / 40, boltMid + 1, 15);
+        display.fillTriangle(cx - size / 40, boltMid - 1, cx + size / 10, boltMid - 1,
+                             cx - size / 16, boltBottom, 15);
+    }
+    else if (strcmp(iconName, "clear_night") == 0) {
+        // Crescent moon: filled disc with an offset white disc cut out
+        int moonRadius = size / 5;
+        display.fillCircle(cx, cy, moonRadius, 15);
+        display.fillCircle(cx + moonRadius / 2, cy - moonRadius / 3, moonRadius * 4 / 5, 0);
+    }
+    else if (strcmp(iconName, "partly_cloudy_night") == 0) {
+        // Crescent moon behind cloud (same layout as partly_cloudy)
+        int moonRadius = size / 7;
+        int moonX = cx - size / 6;
+        int moonY = cy - size / 6;
+        display.fillCircle(moonX, moonY, moonRadius, 15);
+        display.fillCircle(moonX + moonRadius / 2, moonY - moonRadius / 3, moonRadius * 4 / 5, 0);
+
+        int cloudY = cy + size / 10;
+        display.fillCircle(cx - size / 8, cloudY, size / 8, 15);
+        display.fillCircle(cx, cloudY - size / 12, size / 7, 15);
+        display.fillCircle(cx + size / 8, cloudY, size / 8, 15);
+        display.fillRect(cx - size / 6, cloudY, size / 3, size / 8, 15);
+    }
 }
 
-void drawHeader(M5EPD_Canvas& display, const char* location, unsigned long updateTime, unsigned long nextWakeTime, bool isFallback) {
+void drawHeader(M5EPD_Canvas& display, const char* location, unsigned long updateTime, unsigned long nextWakeTime, bool isFallback, unsigned long cacheAge) {
     // Draw header background
     display.fillRect(0, HEADER_Y, SCREEN_WIDTH, HEADER_HEIGHT, 0);
     display.drawFastHLine(0, HEADER_HEIGHT, SCREEN_WIDTH, 15);
@@ -209,27 +289,34 @@ void drawHeader(M5EPD_Canvas& display, const char* location, unsigned long updat
     setRegularFont(display, 24);
     display.setTextDatum(TR_DATUM);
 
-    // Line 1: Last Netatmo update time
-    if (updateTime > 0) {
+    // Line 1: Last update time, or how old the cached data is
+    if (cacheAge > 0) {
+        char cacheStr[40];
+        if (cacheAge < 3600) {
+            snprintf(cacheStr, sizeof(cacheStr), "Offline, Daten vor %lu min", cacheAge / 60);
+        } else {
+            snprintf(cacheStr, sizeof(cacheStr), "Offline, Daten vor %lu h %02lu min",
+                    cacheAge / 3600, (cacheAge % 3600) / 60);
+        }
+        display.drawString(cacheStr, SCREEN_WIDTH - MARGIN, HEADER_Y + 3);
+    } else if (updateTime > 0) {
         char updateStr[32];
-        time_t t = updateTime;
-        struct tm* tm = localtime(&t);
+        CivilDateTime local = LocalTime::breakdown(updateTime);
         snprintf(updateStr, sizeof(updateStr), "Aktualisiert: %02d.%02d. %02d:%02d",
-                tm->tm_mday, tm->tm_mon + 1, tm->tm_hour, tm->tm_min);
+                local.day, local.month, local.hour, local.minute);
         display.drawString(updateStr, SCREEN_WIDTH - MARGIN, HEADER_Y + 3);
     }
 
     // Line 2: Next scheduled wake time
     if (nextWakeTime > 0) {
         char nextStr[48];
-        time_t t = nextWakeTime;
-        struct tm* tm = localtime(&t);
+        CivilDateTime local = LocalTime::breakdown(nextWakeTime);
         if (isFallback) {
             snprintf(nextStr, sizeof(nextStr), "Nächstes: %02d:%02d (Fallback)",
-                    tm->tm_hour, tm->tm_min);
+                    local.hour, local.minute);
         } else {
             snprintf(nextStr, sizeof(nextStr), "Nächstes: %02d:%02d",
-                    tm->tm_hour, tm->tm_min);
+                    local.hour, local.minute);
         }
         display.drawString(nextStr, SCREEN_WIDTH - MARGIN, HEADER_Y + 28);
     }
@@ -259,7 +346,11 @@ void drawIndoorTempWidget(M5EPD_Canvas& display, const IndoorData& data) {
     display.drawString("°C", valueX + textW + 6, valueY + 26);
 
     // Trend arrow
-    drawTrendArrow(display, INDOOR_TEMP_X + CARD_TREND_X_OFFSET, INDOOR_TEMP_Y + CARD_TREND_Y, data.temperatureTrend);
+    if (data.cachedTime != 0) {
+        drawCachedMarker(display, INDOOR_TEMP_X, INDOOR_TEMP_Y, data.cachedTime);
+    } else {
+        drawTrendArrow(display, INDOOR_TEMP_X + CARD_TREND_X_OFFSET, INDOOR_TEMP_Y + CARD_TREND_Y, data.temperatureTrend);
+    }
 
     // Min/max detail (two lines)
     if (data.minTemp != 0 || data.maxTemp != 0) {
@@ -319,7 +410,11 @@ void drawOutdoorTempWidget(M5EPD_Canvas& display, const OutdoorData& data) {
     setRegularFont(display, 28);
     display.drawString("°C", valueX + textW + 6, valueY + 26);
 
-    drawTrendArrow(display, OUTDOOR_TEMP_X + CARD_TREND_X_OFFSET, OUTDOOR_TEMP_Y + CARD_TREND_Y, data.temperatureTrend);
+    if (data.cachedTime != 0) {
+        drawCachedMarker(display, OUTDOOR_TEMP_X, OUTDOOR_TEMP_Y, data.cachedTime);
+    } else {
+        drawTrendArrow(display, OUTDOOR_TEMP_X + CARD_TREND_X_OFFSET, OUTDOOR_TEMP_Y + CARD_TREND_Y, data.temperatureTrend);
+    }
 
     // Min/max detail (two lines)
     if (data.minTemp != 0 || data.maxTemp != 0) {
@@ -376,6 +471,10 @@ void drawIndoorHumidWidget(M5EPD_Canvas& display, const IndoorData& data) {
     setRegularFont(display, 28);
     display.drawString("%", valueX + textW + 6, valueY + 26);
 
+    if (data.cachedTime != 0) {
+        drawCachedMarker(display, INDOOR_HUMID_X, INDOOR_HUMID_Y, data.cachedTime);
+    }
+
     // Climate status: label regular, value bold
     const char* status = getHumidityComfort(data.humidity);
     display.setTextDatum(TL_DATUM);
@@ -412,6 +511,10 @@ void drawOutdoorHumidWidget(M5EPD_Canvas& display, const OutdoorData& data) {
     setRegularFont(display, 28);
     display.drawString("%", valueX + textW + 6, valueY + 26);
 
+    if (data.cachedTime != 0) {
+        drawCachedMarker(display, OUTDOOR_HUMID_X, OUTDOOR_HUMID_Y, data.cachedTime);
+    }
+
     // Dew point calculation (Magnus formula)
     float a = 17.27;
     float b = 237.7;
@@ -455,7 +558,11 @@ void drawAirQualityWidget(M5EPD_Canvas& display, const IndoorData& data) {
     setRegularFont(display, 28);
     display.drawString("ppm", valueX + textW + 6, valueY + 26);
 
-    drawTrendArrow(display, AIR_QUALITY_X + CARD_TREND_X_OFFSET, AIR_QUALITY_Y + CARD_TREND_Y, data.co2Trend);
+    if (data.cachedTime != 0) {
+        drawCachedMarker(display, AIR_QUALITY_X, AIR_QUALITY_Y, data.cachedTime);
+    } else {
+        drawTrendArrow(display, AIR_QUALITY_X + CARD_TREND_X_OFFSET, AIR_QUALITY_Y + CARD_TREND_Y, data.co2Trend);
+    }
 }
 
 void drawPressureWidget(M5EPD_Canvas& display, const IndoorData& data) {
@@ -481,7 +588,11 @@ void drawPressureWidget(M5EPD_Canvas& display, const IndoorData& data) {
     setRegularFont(display, 28);
     display.drawString("hPa", valueX + textW + 6, valueY + 26);
 
-    drawTrendArrow(display, PRESSURE_X + CARD_TREND_X_OFFSET, PRESSURE_Y + CARD_TREND_Y, data.pressureTrend);
+    if (data.cachedTime != 0) {
+        drawCachedMarker(display, PRESSURE_X, PRESSURE_Y, data.cachedTime);
+    } else {
+        drawTrendArrow(display, PRESSURE_X + CARD_TREND_X_OFFSET, PRESSURE_Y + CARD_TREND_Y, data.pressureTrend);
+    }
 }
 
 // Helper to draw a small up or down triangle arrow (8px)
@@ -493,6 +604,96 @@ static void drawSmallArrow(M5EPD_Canvas& display, int x, int y, bool isUp) {
     }
 }
 
+// Series points whose hour overlaps the next 24 h. False if there are too
+// few for a chart (hub data, or a series older than a day).
+static bool hourlyChartRange(const HourlySeries& series, time_t now, uint8_t& first, uint8_t& last) {
+    first = series.count;
+    last = 0;
+    for (uint8_t i = 0; i < series.count; i++) {
+        time_t t = series.timeAt(i);
+        if ((time_t)(t + 3600) <= now || t > now + 86400) continue;
+        if (first == series.count) first = i;
+        last = i;
+    }
+    return first < series.count && last - first >= 2;
+}
+
+// Next 24 h from the met.no series: temperature line over hourly
+// precipitation bars, with the same min/max and sum columns as a day row
+static void drawHourlyChart(M5EPD_Canvas& display, const HourlySeries& series,
+                            uint8_t first, uint8_t last, int baseX, int rowY, time_t now) {
+    const int plotX = baseX + FORECAST_CHART_X;
+    const int plotW = FORECAST_CHART_WIDTH;
+    const int plotY = rowY + 8;
+    const int plotH = 64;
+
+    int16_t tMin = INT16_MAX;
+    int16_t tMax = INT16_MIN;
+    int precipSum = 0;
+    for (uint8_t i = first; i <= last; i++) {
+        tMin = min(tMin, series.temperature[i]);
+        tMax = max(tMax, series.temperature[i]);
+        precipSum += series.precipitation[i];
+    }
+    int tSpan = max(tMax - tMin, 20);  // At least 2 °C so flat days stay flat
+
+    auto xOf = [&](time_t t) {
+        long dx = (long)(t - now) * plotW / 86400;
+        return plotX + (int)constrain(dx, 0L, (long)plotW);
+    };
+
+    display.setTextColor(15, 0);
+    setBoldFont(display, 28);
+    display.setTextDatum(TL_DATUM);
+    display.drawString("24h", baseX + FORECAST_DAY_COL_X, rowY + 4);
+
+    // Baseline with ticks at local 00/06/12/18
+    display.drawFastHLine(plotX, plotY + plotH, plotW, 8);
+    for (uint8_t i = first; i <= last; i++) {
+        if (LocalTime::breakdown(series.timeAt(i)).hour % 6 == 0) {
+            display.drawFastVLine(xOf(series.timeAt(i)), plotY + plotH - 4, 8, 8);
+        }
+    }
+
+    // Precipitation bars (full height = 5 mm/h)
+    int barW = max(plotW / 24 - 2, 2);
+    for (uint8_t i = first; i <= last; i++) {
+        if (series.precipitation[i] == 0) continue;
+        int h = min((int)series.precipitation[i], 50) * plotH / 50;
+        display.fillRect(xOf(series.timeAt(i)) + 1, plotY + plotH - h, barW, max(h, 2), 8);
+    }
+
+    // Temperature line (two pixels thick)
+    int prevX = 0, prevY = 0;
+    for (uint8_t i = first; i <= last; i++) {
+        int x = xOf(series.timeAt(i));
+        int y = plotY + plotH - 4 - (series.temperature[i] - tMin) * (plotH - 8) / tSpan;
+        if (i > first) {
+            display.drawLine(prevX, prevY, x, y, 15);
+            display.drawLine(prevX, prevY + 1, x, y + 1, 15);
+        }
+        prevX = x;
+        prevY = y;
+    }
+
+    // Precipitation total and range, aligned with the day rows
+    char precipStr[16];
+    snprintf(precipStr, sizeof(precipStr), "%.1fmm", precipSum / 10.0);
+    setRegularFont(display, 24);
+    display.setTextDatum(TL_DATUM);
+    display.drawString(precipStr, baseX + FORECAST_PRECIP_X, rowY + 18);
+
+    int rangeX = baseX + FORECAST_RANGE_X;
+    int rangeY = rowY + 46;
+    char minStr[8], maxUnit[12];
+    snprintf(minStr, sizeof(minStr), "%d", tMin / 10);
+    snprintf(maxUnit, sizeof(maxUnit), "%d°C", tMax / 10);
+    drawSmallArrow(display, rangeX, rangeY + 5, false);
+    int w = display.drawString(minStr, rangeX + 14, rangeY);
+    drawSmallArrow(display, rangeX + 14 + w + 4, rangeY + 1, true);
+    display.drawString(maxUnit, rangeX + 14 + w + 18, rangeY);
+}
+
 void drawForecastWidget(M5EPD_Canvas& display, const ForecastData& forecast) {
     // Full-width forecast card
     drawCard(display, FORECAST_WIDGET_X, FORECAST_WIDGET_Y, FORECAST_CARD_HEIGHT, FULL_CARD_WIDTH);
@@ -511,7 +712,7 @@ void drawForecastWidget(M5EPD_Canvas& display, const ForecastData& forecast) {
 
     // Get day names
     time_t now = time(nullptr);
-    struct tm* tm = localtime(&now);
+    CivilDateTime localNow = LocalTime::breakdown(now);
 
     const char* dayNames[] = {"So", "Mo", "Di", "Mi", "Do", "Fr", "Sa"};
 
@@ -519,33 +720,27 @@ void drawForecastWidget(M5EPD_Canvas& display, const ForecastData& forecast) {
     time_t todayTs = forecast.days[0].date ? forecast.days[0].date : now;
 
     // Determine current hour for skipping past slots
-    int currentHour = tm->tm_hour;
+    int currentHour = localNow.hour;
 
     // Get today's midnight for date comparison
-    struct tm todayMidnight = *tm;
-    todayMidnight.tm_hour = 0;
-    todayMidnight.tm_min = 0;
-    todayMidnight.tm_sec = 0;
-    time_t todayMidnightTs = mktime(&todayMidnight);
+    time_t todayMidnightTs = LocalTime::startOfDay(now);
 
-    // Draw up to 4 rows (skip today if all slots are past)
+    // Draw up to 4 rows (skip today if all slots are past); the last row
+    // holds the 24 h chart when the hourly series is available
     int dayHeight = 84;
     int startY = FORECAST_WIDGET_Y + 32;
     int rowIndex = 0;
+    uint8_t chartFirst, chartLast;
+    bool showChart = hourlyChartRange(forecast.hourly, now, chartFirst, chartLast);
+    int dayRows = showChart ? 3 : 4;
 
-    for (int day = 0; day < 4 && rowIndex < 4; day++) {
+    for (int day = 0; day < 4 && rowIndex < dayRows; day++) {
         const DailyForecast& df = forecast.days[day];
 
         // Check if this day is today
         bool isToday = false;
         if (df.date) {
-            struct tm* dayTm = localtime((time_t*)&df.date);
-            struct tm dayMidnight = *dayTm;
-            dayMidnight.tm_hour = 0;
-            dayMidnight.tm_min = 0;
-            dayMidnight.tm_sec = 0;
-            time_t dayMidnightTs = mktime(&dayMidnight);
-            isToday = (dayMidnightTs == todayMidnightTs);
+            isToday = (LocalTime::startOfDay(df.date) == todayMidnightTs);
         }
 
         // For today, determine which slots are still in the future
@@ -576,8 +771,7 @@ void drawForecastWidget(M5EPD_Canvas& display, const ForecastData& forecast) {
 
         // Day label
         time_t rowTs = df.date ? df.date : (todayTs + day * 86400);
-        struct tm* rowTm = localtime(&rowTs);
-        int dayOfWeek = rowTm ? rowTm->tm_wday : ((tm->tm_wday + day) % 7);
+        int dayOfWeek = LocalTime::breakdown(rowTs).weekday;
         setBoldFont(display, 28);
         display.setTextDatum(TL_DATUM);
         display.drawString(dayNames[dayOfWeek], baseX + FORECAST_DAY_COL_X, rowY + 4);
@@ -668,6 +862,14 @@ void drawForecastWidget(M5EPD_Canvas& display, const ForecastData& forecast) {
         snprintf(maxUnit, sizeof(maxUnit), "%s°C", maxStr);
         display.drawString(maxUnit, rangeX + 14 + w + 18, rangeY);
     }
+
+    if (showChart) {
+        int rowY = startY + (rowIndex * dayHeight);
+        if (rowIndex > 0) {
+            display.drawFastHLine(baseX + 8, rowY - 4, FULL_CARD_WIDTH - 16, 8);
+        }
+        drawHourlyChart(display, forecast.hourly, chartFirst, chartLast, baseX, rowY, now);
+    }
 }
 
 void drawBatteryWidget(M5EPD_Canvas& display, const BatteryStatus& status) {
@@ -702,11 +904,52 @@ void drawBatteryWidget(M5EPD_Canvas& display, const BatteryStatus& status) {
     display.drawString(status.label, BATTERY_X + 340, BATTERY_Y + 12);
 }
 
+void drawRoomsWidget(M5EPD_Canvas& display, const WeatherData& data) {
+    if (data.roomCount == 0) return;
+
+    // One column per room: name, temperature, humidity/CO2
+    drawCard(display, ROOMS_X, ROOMS_Y, ROOMS_CARD_HEIGHT, FULL_CARD_WIDTH);
+    display.setTextColor(15, 0);
+    display.setTextDatum(TC_DATUM);
+
+    int columnWidth = FULL_CARD_WIDTH / data.roomCount;
+    for (int i = 0; i < data.roomCount; i++) {
+        const RoomData& room = data.rooms[i];
+        int x = ROOMS_X + i * columnWidth;
+        int cx = x + columnWidth / 2;
+
+        if (i > 0) {
+            display.drawFastVLine(x, ROOMS_Y + 8, ROOMS_CARD_HEIGHT - 16, 8);  // light gray line
+        }
+
+        setRegularFont(display, 24);
+        display.drawString(room.name, cx, ROOMS_Y + CARD_LABEL_Y);
+
+        if (!room.valid) {
+            display.drawString("--", cx, ROOMS_Y + 36);
+            continue;
+        }
+
+        char valueStr[16];
+        snprintf(valueStr, sizeof(valueStr), "%.1f°C", room.temperature);
+        setBoldFont(display, 28);
+        display.drawString(valueStr, cx, ROOMS_Y + 34);
+
+        if (room.co2 > 0) {
+            snprintf(valueStr, sizeof(valueStr), "%d%% %dppm", room.humidity, room.co2);
+        } else {
+            snprintf(valueStr, sizeof(valueStr), "%d%%", room.humidity);
+        }
+        setRegularFont(display, 24);
+        display.drawString(valueStr, cx, ROOMS_Y + 68);
+    }
+}
+
 void drawDashboard(M5EPD_Canvas& display, const DashboardData& data) {
     display.fillCanvas(0);  // White background (M5EPD uses fillCanvas, not fillScreen)
 
     // Header
-    drawHeader(display, LOCATION_NAME, data.updateTime, data.nextWakeTime, data.isFallback);
+    drawHeader(display, LOCATION_NAME, data.updateTime, data.nextWakeTime, data.isFallback, data.cacheAge);
 
     // ROW 1: Temperature (col1=indoor, col2=outdoor)
     drawIndoorTempWidget(display, data.weather.indoor);
@@ -725,6 +968,9 @@ void drawDashboard(M5EPD_Canvas& display, const DashboardData& data) {
 
     // ROW 5: Full-width battery bar
     drawBatteryWidget(display, evaluateBattery(data.batteryVoltage));
+
+    // ROW 6: Extra rooms (NAModule4 / other stations)
+    drawRoomsWidget(display, data.weather);
 }
 
 // Legacy function names for compatibility
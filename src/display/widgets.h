@@ -19,9 +19,10 @@ void drawOutdoorHumidWidget(M5EPD_Canvas& display, const OutdoorData& data);
 
 void drawForecastWidget(M5EPD_Canvas& display, const ForecastData& forecast);
 void drawBatteryWidget(M5EPD_Canvas& display, const BatteryStatus& status);
+void drawRoomsWidget(M5EPD_Canvas& display, const WeatherData& data);
 
 // Header with update times
-void drawHeader(M5EPD_Canvas& display, const char* location, unsigned long updateTime, unsigned long nextWakeTime, bool isFallback = false);
+void drawHeader(M5EPD_Canvas& display, const char* location, unsigned long updateTime, unsigned long nextWakeTime, bool isFallback = false, unsigned long cacheAge = 0);
 
 // Complete dashboard renderer
 void drawDashboard(M5EPD_Canvas& display, const DashboardData& data);
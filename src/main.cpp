@@ -1,21 +1,31 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <time.h>
+#include <esp_sntp.h>
 #include <M5EPD.h>
 #include "config.h"
 
 // API clients
-#include "api/netatmo_client.h"
-#include "api/meteo_client.h"
+#include "api/providers.h"
+#include "api/http_utils.h"
+#include "api/hub_client.h"
+
+// Time
+#include "time/local_time.h"
 
 // Display
 #include "display/layout.h"
 #include "display/widgets.h"
 #include "display/fonts.h"
+#include "display/screen_snapshot.h"
 
 // Data
 #include "data/weather_data.h"
 #include "data/cache.h"
+#include "data/history_log.h"
+#include "data/forecast_aggregator.h"
+#include "data/json_arena.h"
+#include "data/alloc_counter.h"
 
 // Power management
 #include "power/sleep_manager.h"
@@ -24,14 +34,22 @@
 // Global objects
 M5EPD_Canvas canvas(&M5.EPD);
 
-NetatmoClient netatmoClient;
-MeteoClient meteoClient;
+ConditionsSource conditionsSource;
+ForecastSource forecastSource;
+HubClient hubClient;
+
+// Dashboard of this wake and the last cached one, loaded before the network
+// phase (static: two of them are too large for the loop task stack)
+DashboardData dashboardData;
+DashboardData cachedData;
 
 // Function prototypes
 bool connectWiFi();
 void disconnectWiFi();
 bool syncTime();
 bool fetchWeatherData(DashboardData& data);
+bool loadCachedData(DashboardData& data);
+void mergeCachedModules(DashboardData& data, const DashboardData& cached);
 void updateDisplay(const DashboardData& data);
 unsigned long calculateNextWakeTime(unsigned long netatmoLastUpdate, bool& isFallback);
 void enterSleep(unsigned long nextWakeTime);
@@ -75,18 +93,12 @@ void setup() {
         ESP_LOGE("main", "Failed to initialize cache");
     }
 
-    // Configure timezone for Switzerland (must be done on every boot as it doesn't persist)
-    // POSIX TZ string: CET-1CEST,M3.5.0,M10.5.0/3
-    // - CET-1: Central European Time, UTC+1
-    // - CEST: Central European Summer Time
-    // - M3.5.0: DST starts last Sunday in March at 02:00
-    // - M10.5.0/3: DST ends last Sunday in October at 03:00
-    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
-    tzset();
-    ESP_LOGI("main", "Timezone configured: CET/CEST");
-
-    // Show loading screen only on first boot; keep last display on subsequent wakes
-    if (SleepManager::getWakeCount() == 1) {
+    // Show the last screen (or a loading screen) only on first boot; keep last display on subsequent wakes
+    if (SleepManager::getWakeCount() == 1 && ScreenSnapshot::restore(canvas)) {
+        ESP_LOGI("main", "Wake #%d - restoring last screen", SleepManager::getWakeCount());
+        M5.EPD.Clear(true);
+        canvas.pushCanvas(0, 0, UPDATE_MODE_GC16);
+    } else if (SleepManager::getWakeCount() == 1) {
         ESP_LOGI("main", "Wake #%d - showing initial loading screen", SleepManager::getWakeCount());
         M5.EPD.Clear(true);
 
@@ -107,14 +119,18 @@ void setup() {
         canvas.drawString("(Erstmalige Initialisierung)", SCREEN_WIDTH/2, SCREEN_HEIGHT/2 + 80);
 
         canvas.pushCanvas(0, 0, UPDATE_MODE_GC16);
+        ScreenSnapshot::save(canvas);
         delay(500);  // Brief pause to ensure display update completes
     } else {
         ESP_LOGI("main", "Wake #%d - keeping previous display during data refresh", SleepManager::getWakeCount());
     }
 
-    // Prepare dashboard data
-    DashboardData dashboardData;
     bool dataAvailable = false;
+    bool freshData = false;
+
+    // Cached data is ready before the fetch, so a failed or partial fetch
+    // falls back without extra work after the network phase
+    bool cacheAvailable = loadCachedData(cachedData);
 
     // Lower CPU frequency for WiFi/API fetch phase (80 MHz is sufficient, saves ~60% dynamic power)
     setCpuFrequencyMhz(80);
@@ -122,27 +138,36 @@ void setup() {
 
     // Connect WiFi
     if (connectWiFi()) {
-        // Sync time if needed
-        if (SleepManager::shouldSyncTime()) {
-            if (syncTime()) {
-                ESP_LOGI("main", "Time synchronized successfully");
-            } else {
-                ESP_LOGW("main", "Time sync failed, using RTC time");
-            }
-        }
+        // Discipline the clock from the first API response's Date header
+        HTTPUtils::setServerDateHandler(SleepManager::applyServerTime);
 
         // Fetch fresh weather data
         if (fetchWeatherData(dashboardData)) {
             ESP_LOGI("main", "Weather data fetched successfully");
 
-            // Save to cache for offline use
-            DataCache::save(dashboardData);
+            // Forecast request failed: keep the cached one (dated, re-aggregated per day)
+            if (!dashboardData.forecast.days[0].valid && cacheAvailable && cachedData.forecast.days[0].valid) {
+                ESP_LOGW("main", "Using cached forecast");
+                dashboardData.forecast = cachedData.forecast;
+            }
+
             dataAvailable = true;
+            freshData = true;
             SleepManager::setLastUpdateSuccess(true);
         } else {
             ESP_LOGE("main", "Failed to fetch weather data");
             SleepManager::setLastUpdateSuccess(false);
         }
+
+        // Fall back to NTP only if no usable Date header was received
+        HTTPUtils::setServerDateHandler(nullptr);
+        if (!SleepManager::isTimeSynced() && SleepManager::shouldSyncTime()) {
+            if (syncTime()) {
+                ESP_LOGI("main", "Time synchronized successfully");
+            } else {
+                ESP_LOGW("main", "Time sync failed, using RTC time");
+            }
+        }
     } else {
         ESP_LOGE("main", "WiFi connection failed");
     }
@@ -154,14 +179,16 @@ void setup() {
     setCpuFrequencyMhz(240);
     ESP_LOGI("main", "CPU frequency restored to 240 MHz for display phase");
 
-    // If fresh data not available, try to load from cache
-    if (!dataAvailable) {
-        ESP_LOGI("main", "Attempting to load cached data");
-        if (DataCache::load(dashboardData)) {
-            ESP_LOGI("main", "Loaded data from cache (age: %lu sec)",
-                    DataCache::getAgeSeconds());
-            dataAvailable = true;
+    // If fresh data not available, fall back to the cache; a forecast
+    // fetched this wake is kept
+    if (!dataAvailable && cacheAvailable) {
+        dashboardData.weather = cachedData.weather;
+        if (!dashboardData.forecast.days[0].valid) {
+            dashboardData.forecast = cachedData.forecast;
         }
+        dashboardData.cacheAge = DataCache::getAgeSeconds();
+        ESP_LOGI("main", "Using cached data (age: %lu sec)", dashboardData.cacheAge);
+        dataAvailable = true;
     }
 
     // Read battery (M5Paper) with status mapping
@@ -181,6 +208,23 @@ void setup() {
         ESP_LOGW("main", "Device may not wake up. Please charge battery.");
     }
 
+    if (freshData) {
+        // Local measurement history (only fresh readings, cached ones are already in it)
+        History::record(dashboardData);
+
+        // Modules missing from the response keep their cached readings, marked
+        // with their measurement time; merged after the history was written so
+        // they are not recorded as new measurements, and before the cache is
+        // saved so a module missing for several wakes keeps its last reading
+        if (cacheAvailable) {
+            mergeCachedModules(dashboardData, cachedData);
+        }
+
+        // Save to cache for offline use
+        DataCache::save(dashboardData);
+        JsonArena::instance()->endPhase("cache");
+    }
+
     // Calculate next wake time before display update (so header can show it)
     dashboardData.nextWakeTime = calculateNextWakeTime(dashboardData.weather.timestamp, dashboardData.isFallback);
 
@@ -205,6 +249,7 @@ void setup() {
         canvas.drawString("WiFi und API prüfen", SCREEN_WIDTH/2, SCREEN_HEIGHT/2 + 50);
 
         canvas.pushCanvas(0, 0, UPDATE_MODE_GC16);
+        ScreenSnapshot::save(canvas);
         M5.EPD.Sleep();
     }
 
@@ -236,7 +281,8 @@ bool connectWiFi() {
     }
 
     Serial.println();
-    ESP_LOGI("wifi", "Connected! IP: %s", WiFi.localIP().toString().c_str());
+    ESP_LOGI("wifi", "Connected in %lu ms! IP: %s", millis() - startTime,
+             WiFi.localIP().toString().c_str());
 
     int rssi = WiFi.RSSI();
     ESP_LOGI("wifi", "RSSI: %d dBm", rssi);
@@ -264,15 +310,19 @@ void disconnectWiFi() {
 bool syncTime() {
     ESP_LOGI("time", "Syncing time via NTP");
 
-    // Configure NTP with timezone (ESP32-specific function that handles timezone correctly)
-    // POSIX TZ string: CET-1CEST,M3.5.0,M10.5.0/3
-    configTzTime("CET-1CEST,M3.5.0,M10.5.0/3", NTP_SERVER_1, NTP_SERVER_2);
+    // Clock before the sync, to measure the offset NTP corrects
+    time_t before = time(nullptr);
+    unsigned long startMs = millis();
+
+    // The system clock stays in UTC; local time comes from LocalTime (TIMEZONE)
+    configTime(0, 0, NTP_SERVER_1, NTP_SERVER_2);
 
-    // Wait for time sync (max 15 seconds)
+    // Wait for time sync (max 15 seconds). The sync status is polled rather than
+    // the clock value, which is already plausible when seeded from the RTC.
     int retries = 30;
     while (retries > 0) {
         time_t now = time(nullptr);
-        if (now > 1700000000) {  // Year > 2023
+        if (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED && now > 1700000000) {  // Year > 2023
             struct tm* timeinfo = gmtime(&now);
             ESP_LOGI("time", "Time synced: %04d-%02d-%02d %02d:%02d:%02d UTC",
                     timeinfo->tm_year + 1900,
@@ -282,7 +332,9 @@ bool syncTime() {
                     timeinfo->tm_min,
                     timeinfo->tm_sec);
 
-            SleepManager::writeHardwareRtc(now);
+            time_t expected = before + (time_t)((millis() - startMs) / 1000);
+            long offset = (before > 1700000000) ? (long)(now - expected) : 0;
+            SleepManager::applyNtpTime(now, offset);
             return true;
         }
 
@@ -295,35 +347,113 @@ bool syncTime() {
 }
 
 bool fetchWeatherData(DashboardData& data) {
+    // LAN hub: one small frame replaces all HTTPS requests
+    if (strlen(HUB_HOST) > 0) {
+        if (hubClient.getDashboard(data)) {
+            SleepManager::applyServerTime(hubClient.getServerTime());
+            HTTPUtils::logTimings();
+            return (data.weather.indoor.valid || data.weather.outdoor.valid);
+        }
+        ESP_LOGW("main", "LAN hub unavailable, falling back to direct API access");
+    }
+
     ESP_LOGI("main", "Fetching weather data from APIs");
+    AllocCounter::endPhase("wifi");
 
     bool success = true;
 
-    // Fetch Netatmo data
-    if (!netatmoClient.getWeatherData(data.weather)) {
-        ESP_LOGE("main", "Failed to fetch Netatmo data");
+    // Fetch current conditions (CONDITIONS_PROVIDER)
+    if (!conditionsSource.fetchConditions(data.weather)) {
+        ESP_LOGE("main", "Failed to fetch current conditions");
         success = false;
     }
+    JsonArena::instance()->endPhase("conditions");
+    AllocCounter::endPhase("conditions");
 
-    // Fetch met.no forecast data
-    if (!meteoClient.getForecast(data.forecast)) {
+    // Fetch forecast data (FORECAST_PROVIDER)
+    if (!forecastSource.fetchForecast(data.forecast)) {
         ESP_LOGW("main", "Failed to fetch forecast data");
     }
+    JsonArena::instance()->endPhase("forecast");
+    AllocCounter::endPhase("forecast");
+
+    // Per-request DNS/connect/TTFB/transfer/parse breakdown
+    HTTPUtils::logTimings();
 
     // Even if one API fails, we can still show partial data
     return (data.weather.indoor.valid || data.weather.outdoor.valid);
 }
 
+bool loadCachedData(DashboardData& data) {
+    if (!DataCache::load(data)) {
+        return false;
+    }
+
+    // Series for the hourly chart; re-derive the days if the cache
+    // predates local midnight
+    time_t now = SleepManager::getEpoch();
+    if (DataCache::loadHourly(data.forecast.hourly) &&
+        data.forecast.days[0].date != (unsigned long)LocalTime::startOfDay(now)) {
+        ESP_LOGI("main", "Cached forecast is from an earlier day, re-aggregating");
+        ForecastAggregator::aggregate(data.forecast, now);
+    }
+    return true;
+}
+
+// Copy a cached module reading into a fresh response that lacks it, unless
+// it is older than CACHE_MAX_AGE_SEC (carried over for too many wakes)
+template <typename Module>
+static void mergeCachedModule(Module& module, const Module& cached, unsigned long cachedTimestamp,
+                              time_t now, const char* name) {
+    if (module.valid || !cached.valid) {
+        return;
+    }
+
+    // A reading already carried over keeps its original measurement time
+    unsigned long measuredAt = cached.cachedTime ? cached.cachedTime : cachedTimestamp;
+    if (measuredAt == 0 || now - (time_t)measuredAt > CACHE_MAX_AGE_SEC) {
+        ESP_LOGW("main", "%s module missing, cached reading too old", name);
+        return;
+    }
+
+    module = cached;
+    module.cachedTime = measuredAt;
+    ESP_LOGW("main", "%s module missing, showing cached reading (%ld sec old)",
+             name, (long)(now - (time_t)measuredAt));
+}
+
+void mergeCachedModules(DashboardData& data, const DashboardData& cached) {
+    WeatherData& weather = data.weather;
+    const WeatherData& old = cached.weather;
+    time_t now = SleepManager::getEpoch();
+
+    mergeCachedModule(weather.indoor, old.indoor, old.timestamp, now, "Indoor");
+    mergeCachedModule(weather.outdoor, old.outdoor, old.timestamp, now, "Outdoor");
+    mergeCachedModule(weather.wind, old.wind, old.timestamp, now, "Wind");
+    mergeCachedModule(weather.rain, old.rain, old.timestamp, now, "Rain");
+}
+
 void updateDisplay(const DashboardData& data) {
     ESP_LOGI("display", "Updating ePaper display");
 
-    // Hard-refresh on every wake to clear ghosting artifacts (graue Linien)
-    M5.EPD.Clear(true);
-
     // Clear canvas and draw dashboard
     canvas.fillCanvas(0);
     drawDashboard(canvas, data);
 
+    // Compare with the screen pushed last time
+    ScreenArea changed;
+    if (ScreenSnapshot::changedArea(canvas, changed)) {
+        if (changed.empty()) {
+            ESP_LOGI("display", "Screen unchanged, refresh skipped");
+            M5.EPD.Sleep();
+            return;
+        }
+        ESP_LOGI("display", "Changed area: %dx%d at (%d,%d)", changed.w, changed.h, changed.x, changed.y);
+    }
+
+    // Hard-refresh on every wake to clear ghosting artifacts (graue Linien)
+    M5.EPD.Clear(true);
+
     // Push canvas to display (takes ~2 seconds)
     ESP_LOGI("display", "Pushing canvas to display...");
     unsigned long startTime = millis();
@@ -331,6 +461,8 @@ void updateDisplay(const DashboardData& data) {
     unsigned long duration = millis() - startTime;
     ESP_LOGI("display", "Display updated in %lu ms", duration);
 
+    ScreenSnapshot::save(canvas);
+
     // Put display to sleep
     M5.EPD.Sleep();
 }
@@ -340,19 +472,16 @@ unsigned long calculateNextWakeTime(unsigned long netatmoLastUpdate, bool& isFal
     isFallback = false;
 
     // Night mode: 00:00–05:59 local time → hourly wakes, capped at 06:00
-    struct tm localNow;
-    localtime_r(&now, &localNow);
-    if (localNow.tm_hour >= 0 && localNow.tm_hour < 6) {
-        struct tm wakeTime = localNow;
-        wakeTime.tm_hour += 1;
-        wakeTime.tm_min = 0;
-        wakeTime.tm_sec = 0;
-        if (wakeTime.tm_hour >= 6) {
-            wakeTime.tm_hour = 6;
+    CivilDateTime localNow = LocalTime::breakdown(now);
+    if (localNow.hour < 6) {
+        unsigned wakeHour = localNow.hour + 1;
+        if (wakeHour >= 6) {
+            wakeHour = 6;
         }
-        time_t nightWake = mktime(&wakeTime);
-        ESP_LOGI("sleep", "Night mode: next wake at %02d:%02d local (%ld sec)",
-                 wakeTime.tm_hour, wakeTime.tm_min, (long)(nightWake - now));
+        time_t nightWake = LocalTime::fromLocal(localNow.year, localNow.month, localNow.day,
+                                                wakeHour, 0, 0);
+        ESP_LOGI("sleep", "Night mode: next wake at %02u:00 local (%ld sec)",
+                 wakeHour, (long)(nightWake - now));
         return nightWake;
     }
 
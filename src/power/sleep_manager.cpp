@@ -6,58 +6,101 @@
 #include <WiFi.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include "../data/json_arena.h"
+#include "../data/state_store.h"
+#include "../time/civil_time.h"
 
-// File path for persistent state
-static const char* STATE_FILE = "/sleep_state.json";
+// State file of earlier firmware, migrated into the state store
+static const char* LEGACY_STATE_FILE = "/sleep_state.json";
 
-// Static variables (loaded from LittleFS on init)
+// True if the hardware RTC held a valid time at boot (drift samples need it)
+static bool rtcValidAtBoot = false;
+
+// Static variables (loaded from the state store on init)
 uint8_t SleepManager::wakeCount = 0;
 bool SleepManager::lastUpdateSuccess = false;
+bool SleepManager::timeSynced = false;
+uint32_t SleepManager::lastSyncEpoch = 0;
+uint32_t SleepManager::rtcSetEpoch = 0;
+float SleepManager::driftPpm = 0;
+uint8_t SleepManager::driftSamples = 0;
+uint32_t SleepManager::driftBaselineSec = 0;
+long SleepManager::rtcCorrectionSec = 0;
 
 void SleepManager::loadState() {
-    if (!LittleFS.exists(STATE_FILE)) {
-        ESP_LOGI("sleep", "No state file found - this is first boot");
+    if (StateStore::load()) {
+        const SleepState& state = StateStore::state().sleep;
+        const VolatileState& wake = StateStore::volatileState();
+        wakeCount = wake.wakeCount;
+        lastUpdateSuccess = wake.lastUpdateSuccess;
+        lastSyncEpoch = wake.lastSyncEpoch;
+        rtcSetEpoch = state.rtcSetEpoch;
+        driftPpm = state.driftPpm;
+        driftSamples = state.driftSamples;
+        driftBaselineSec = StateStore::state().drift.baselineSec;
+    } else if (!loadLegacyState()) {
+        ESP_LOGI("sleep", "No state found - this is first boot");
         wakeCount = 0;
         return;
     }
 
-    File file = LittleFS.open(STATE_FILE, "r");
+    // Model of earlier firmware without a weight: keep it as one minimal sample
+    if (driftSamples > 0 && driftBaselineSec == 0) {
+        driftSamples = 1;
+        driftBaselineSec = RTC_DRIFT_MIN_BASELINE_SEC;
+    }
+
+    ESP_LOGI("sleep", "State loaded: wakeCount=%d, lastSuccess=%d, drift=%.1f ppm (n=%d, %lu sec)",
+             wakeCount, lastUpdateSuccess, driftPpm, driftSamples, (unsigned long)driftBaselineSec);
+}
+
+bool SleepManager::loadLegacyState() {
+    if (!LittleFS.exists(LEGACY_STATE_FILE)) {
+        return false;
+    }
+
+    File file = LittleFS.open(LEGACY_STATE_FILE, "r");
     if (!file) {
-        ESP_LOGW("sleep", "Failed to open state file");
-        return;
+        ESP_LOGW("sleep", "Failed to open legacy state file");
+        return false;
     }
 
-    JsonDocument doc;
+    JsonDocument doc(JsonArena::instance());
     DeserializationError error = deserializeJson(doc, file);
     file.close();
+    LittleFS.remove(LEGACY_STATE_FILE);
 
     if (error) {
-        ESP_LOGW("sleep", "Failed to parse state file: %s", error.c_str());
-        return;
+        ESP_LOGW("sleep", "Failed to parse legacy state file: %s", error.c_str());
+        return false;
     }
 
     wakeCount = doc["wakeCount"] | 0;
     lastUpdateSuccess = doc["lastSuccess"] | false;
+    lastSyncEpoch = doc["lastSync"] | 0;
+    rtcSetEpoch = doc["rtcSet"] | 0;
+    driftPpm = doc["driftPpm"] | 0.0f;
+    driftSamples = doc["driftN"] | 0;
 
-    ESP_LOGI("sleep", "State loaded: wakeCount=%d, lastSuccess=%d",
-             wakeCount, lastUpdateSuccess);
+    ESP_LOGI("sleep", "Legacy state file migrated");
+    return true;
 }
 
 void SleepManager::saveState() {
-    File file = LittleFS.open(STATE_FILE, "w");
-    if (!file) {
-        ESP_LOGE("sleep", "Failed to create state file");
-        return;
-    }
-
-    JsonDocument doc;
-    doc["wakeCount"] = wakeCount;
-    doc["lastSuccess"] = lastUpdateSuccess;
-
-    serializeJson(doc, file);
-    file.close();
-
-    ESP_LOGI("sleep", "State saved to LittleFS");
+    VolatileState& wake = StateStore::volatileState();
+    wake.wakeCount = wakeCount;
+    wake.lastUpdateSuccess = lastUpdateSuccess;
+    wake.lastSyncEpoch = lastSyncEpoch;
+
+    SleepState& state = StateStore::state().sleep;
+    state.rtcSetEpoch = rtcSetEpoch;
+    state.driftPpm = driftPpm;
+    state.driftSamples = driftSamples;
+    StateStore::state().drift.baselineSec = driftBaselineSec;
+
+    // The one state write of the wake (tokens, validators and cache included),
+    // skipped if only the per-wake values changed
+    StateStore::commitWake();
 }
 
 time_t SleepManager::readHardwareRtc() {
@@ -72,41 +115,40 @@ time_t SleepManager::readHardwareRtc() {
         return 0;
     }
 
-    struct tm timeinfo = {};
-    timeinfo.tm_year = rtcDate.year - 1900;
-    timeinfo.tm_mon = rtcDate.mon - 1;
-    timeinfo.tm_mday = rtcDate.day;
-    timeinfo.tm_hour = rtcTime.hour;
-    timeinfo.tm_min = rtcTime.min;
-    timeinfo.tm_sec = rtcTime.sec;
-    timeinfo.tm_isdst = 0;
-
-    // NOTE: This function must only be called BEFORE setenv("TZ",...) in setup(),
-    // so that mktime() interprets the hardware RTC values as UTC (the default).
-    // After TZ is set, use time(nullptr) instead — the system clock is seeded
-    // from this value in init().
-    time_t epoch = mktime(&timeinfo);
+    // The RTC keeps UTC; convert without going through mktime() and TZ
+    time_t epoch = (time_t)CivilTime::toEpoch(rtcDate.year, rtcDate.mon, rtcDate.day,
+                                              rtcTime.hour, rtcTime.min, rtcTime.sec);
 
     ESP_LOGI("sleep", "Hardware RTC: %04d-%02d-%02d %02d:%02d:%02d UTC (epoch=%ld)",
              rtcDate.year, rtcDate.mon, rtcDate.day,
              rtcTime.hour, rtcTime.min, rtcTime.sec, epoch);
 
+    rtcValidAtBoot = true;
+
+    // Apply the drift accumulated since the RTC was last written
+    rtcCorrectionSec = 0;
+    if (driftSamples > 0 && rtcSetEpoch > 0 && epoch > (time_t)rtcSetEpoch) {
+        rtcCorrectionSec = lroundf((epoch - rtcSetEpoch) * driftPpm / 1e6f);
+        epoch += rtcCorrectionSec;
+        ESP_LOGI("sleep", "RTC drift correction: %+ld sec (%.1f ppm)", rtcCorrectionSec, driftPpm);
+    }
+
     return epoch;
 }
 
 void SleepManager::writeHardwareRtc(time_t epoch) {
-    struct tm* tm = gmtime(&epoch);
+    CivilDateTime utc = CivilTime::fromEpoch(epoch);
 
     rtc_time_t rtcTime;
-    rtcTime.hour = tm->tm_hour;
-    rtcTime.min = tm->tm_min;
-    rtcTime.sec = tm->tm_sec;
+    rtcTime.hour = utc.hour;
+    rtcTime.min = utc.minute;
+    rtcTime.sec = utc.second;
 
     rtc_date_t rtcDate;
-    rtcDate.year = tm->tm_year + 1900;
-    rtcDate.mon = tm->tm_mon + 1;
-    rtcDate.day = tm->tm_mday;
-    rtcDate.week = tm->tm_wday;
+    rtcDate.year = utc.year;
+    rtcDate.mon = utc.month;
+    rtcDate.day = utc.day;
+    rtcDate.week = utc.weekday;
 
     M5.RTC.setTime(&rtcTime);
     M5.RTC.setDate(&rtcDate);
@@ -125,12 +167,11 @@ void SleepManager::init() {
         ESP_LOGE("sleep", "Failed to mount LittleFS");
     }
 
-    // Load persistent state from LittleFS (wakeCount + lastSuccess only)
+    // Load persistent state (wake counter, drift model; the other modules
+    // read their part of the state store later)
     loadState();
 
-    // Read hardware RTC and seed the system clock.
-    // IMPORTANT: This runs BEFORE TZ is configured in setup(), so mktime()
-    // correctly treats the RTC values as UTC.
+    // Read hardware RTC (UTC) and seed the system clock
     time_t hwTime = readHardwareRtc();
     if (hwTime > 0) {
         struct timeval tv = { hwTime, 0 };
@@ -153,7 +194,7 @@ void SleepManager::deepSleepUntil(time_t targetEpoch) {
 
     ESP_LOGI("sleep", "Entering deep sleep for %d seconds (%d min)", seconds, seconds / 60);
 
-    // Save state to LittleFS before shutdown
+    // Save state before shutdown
     saveState();
 
     // Shut down WiFi completely
@@ -178,11 +219,18 @@ void SleepManager::deepSleepUntil(time_t targetEpoch) {
         M5.shutdown(seconds - 1);
     } else {
         // Long sleep: use RTC alarm at specific UTC time (more reliable than
-        // minute-resolution timer which kicks in above 255 seconds)
-        // time(nullptr) returns correct UTC, gmtime converts to UTC clock time,
-        // hardware RTC runs in UTC — so alarm fires at the right moment
+        // minute-resolution timer which kicks in above 255 seconds).
+        // The alarm compares against the raw RTC, which drifted since it was
+        // last written: subtract the correction readHardwareRtc() will add
+        time_t alarmEpoch = targetEpoch;
+        if (driftSamples > 0 && rtcSetEpoch > 0 && targetEpoch > (time_t)rtcSetEpoch) {
+            long alarmCorrectionSec = lroundf((targetEpoch - rtcSetEpoch) * driftPpm / 1e6f);
+            alarmEpoch -= alarmCorrectionSec;
+            ESP_LOGI("sleep", "RTC alarm drift correction: %+ld sec", -alarmCorrectionSec);
+        }
+
         struct tm tmInfo;
-        gmtime_r(&targetEpoch, &tmInfo);
+        gmtime_r(&alarmEpoch, &tmInfo);
         rtc_time_t rtcTime;
         rtcTime.hour = tmInfo.tm_hour;
         rtcTime.min = tmInfo.tm_min;
@@ -230,13 +278,124 @@ bool SleepManager::shouldSyncTime() {
         return true;
     }
 
-    struct tm* tm = gmtime(&now);
+    if (lastSyncEpoch == 0 || now < (time_t)lastSyncEpoch) {
+        ESP_LOGI("sleep", "Time sync needed: No previous sync");
+        return true;
+    }
 
-    // Daily sync around midnight UTC
-    if (tm->tm_hour == 0 && tm->tm_min == 0) {
-        ESP_LOGI("sleep", "Time sync needed: Daily sync at midnight");
+    // Predicted error grows with the time since the last sync; a modelled RTC
+    // only accumulates the residual error of the drift estimate
+    float uncertaintyPpm = driftUncertaintyPpm();
+    float predictedErrorSec = (now - lastSyncEpoch) * uncertaintyPpm / 1e6f;
+
+    if (predictedErrorSec > TIME_SYNC_MAX_ERROR_SEC) {
+        ESP_LOGI("sleep", "Time sync needed: predicted error %.1f sec (%.0f ppm over %ld sec)",
+                 predictedErrorSec, uncertaintyPpm, (long)(now - lastSyncEpoch));
         return true;
     }
 
     return false;
 }
+
+bool SleepManager::applyServerTime(time_t serverEpoch) {
+    if (serverEpoch < 1700000000) {
+        ESP_LOGW("sleep", "Server time implausible (epoch=%ld)", (long)serverEpoch);
+        return false;
+    }
+
+    time_t now = time(nullptr);
+    long drift = (long)(serverEpoch - now);
+
+    // A set clock that disagrees by minutes points at a bad server clock, not RTC drift
+    if (now >= 1700000000 && labs(drift) > HTTP_DATE_MAX_DRIFT_SEC) {
+        ESP_LOGW("sleep", "Server time off by %ld sec (> %d), ignoring",
+                 drift, HTTP_DATE_MAX_DRIFT_SEC);
+        return false;
+    }
+
+    if (now < 1700000000 || labs(drift) >= HTTP_DATE_MIN_CORRECTION_SEC) {
+        struct timeval tv = { serverEpoch, 0 };
+        settimeofday(&tv, NULL);
+        ESP_LOGI("sleep", "Clock set from server time (drift %ld sec)", drift);
+    } else {
+        ESP_LOGI("sleep", "Clock within %ld sec of server time, no correction", drift);
+    }
+
+    recordTimeSync(serverEpoch, (now < 1700000000) ? 0 : drift);
+    return true;
+}
+
+void SleepManager::applyNtpTime(time_t ntpEpoch, long offsetSec) {
+    ESP_LOGI("sleep", "NTP offset: %ld sec", offsetSec);
+    recordTimeSync(ntpEpoch, offsetSec);
+}
+
+void SleepManager::recordTimeSync(time_t trueEpoch, long offsetSec) {
+    timeSynced = true;
+    lastSyncEpoch = trueEpoch;
+
+    // Once the baseline is long enough every sync is a drift sample, small
+    // offsets included (skipping them would bias the model towards large
+    // drift). Before that, an offset within the resolution of the time source
+    // leaves the RTC running untouched so the baseline keeps growing.
+    bool rtcValid = rtcValidAtBoot && rtcSetEpoch > 0;
+    long elapsed = (long)(trueEpoch - (time_t)rtcSetEpoch);
+    bool sampleDue = rtcValid && elapsed >= RTC_DRIFT_MIN_BASELINE_SEC;
+    if (rtcValid && !sampleDue && labs(offsetSec) < HTTP_DATE_MIN_CORRECTION_SEC) {
+        return;
+    }
+
+    // The raw RTC offset is what remains after the boot correction plus the correction itself
+    if (sampleDue) {
+        addDriftSample(offsetSec + rtcCorrectionSec, elapsed);
+    }
+
+    writeHardwareRtc(trueEpoch);
+    rtcSetEpoch = trueEpoch;
+    rtcCorrectionSec = 0;
+}
+
+void SleepManager::addDriftSample(long rawOffsetSec, long elapsedSec) {
+    float samplePpm = rawOffsetSec * 1e6f / elapsedSec;
+    if (fabsf(samplePpm) > RTC_DRIFT_MAX_PPM) {
+        ESP_LOGW("sleep", "RTC drift sample %.1f ppm rejected", samplePpm);
+        return;
+    }
+
+    // A sample outside the combined errors of sample and model means the
+    // model is wrong (or the RTC changed): start over from this sample
+    float sampleErrorPpm = RTC_DRIFT_SAMPLE_ERROR_SEC * 1e6f / elapsedSec;
+    float modelErrorPpm = driftBaselineSec > 0 ? RTC_DRIFT_SAMPLE_ERROR_SEC * 1e6f / driftBaselineSec : 0;
+    if (driftSamples == 0 || fabsf(samplePpm - driftPpm) > sampleErrorPpm + modelErrorPpm) {
+        if (driftSamples > 0) {
+            ESP_LOGW("sleep", "RTC drift sample %.1f +- %.1f ppm disagrees with model %.1f +- %.1f ppm, restarting",
+                     samplePpm, sampleErrorPpm, driftPpm, modelErrorPpm);
+        }
+        driftPpm = samplePpm;
+        driftSamples = 1;
+        driftBaselineSec = elapsedSec;
+    } else {
+        // Mean weighted by run time (total offset over total time); the weight
+        // is capped so older samples fade out
+        uint32_t weight = driftBaselineSec > RTC_DRIFT_MAX_BASELINE_SEC ? RTC_DRIFT_MAX_BASELINE_SEC : driftBaselineSec;
+        driftPpm = (driftPpm * weight + samplePpm * elapsedSec) / (weight + elapsedSec);
+        driftBaselineSec = weight + elapsedSec;
+        if (driftSamples < 255) driftSamples++;
+    }
+
+    ESP_LOGI("sleep", "RTC drift sample %.1f ppm over %ld sec -> model %.1f ppm (n=%d, %lu sec)",
+             samplePpm, elapsedSec, driftPpm, driftSamples, (unsigned long)driftBaselineSec);
+}
+
+float SleepManager::driftUncertaintyPpm() {
+    if (driftSamples < RTC_DRIFT_MIN_SAMPLES || driftBaselineSec == 0) {
+        return RTC_DRIFT_UNMODELED_PPM;
+    }
+
+    float averagingPpm = RTC_DRIFT_SAMPLE_ERROR_SEC * 1e6f / driftBaselineSec;
+    return averagingPpm > RTC_DRIFT_RESIDUAL_PPM ? averagingPpm : RTC_DRIFT_RESIDUAL_PPM;
+}
+
+bool SleepManager::isTimeSynced() {
+    return timeSynced;
+}
@@ -7,19 +7,44 @@
 
 class SleepManager {
 private:
-    // Persisted variables (stored in LittleFS)
+    // Persisted variables (StateStore, data/state_store.h)
     static uint8_t wakeCount;
     static bool lastUpdateSuccess;
 
-    // Load/save state from/to LittleFS
+    // Set once the clock was disciplined during this wake (not persisted)
+    static bool timeSynced;
+
+    // RTC drift model (persisted)
+    static uint32_t lastSyncEpoch;   // Last time the clock was confirmed by a time source
+    static uint32_t rtcSetEpoch;     // Last time the hardware RTC was written
+    static float driftPpm;           // Estimated RTC drift (> 0: RTC runs slow)
+    static uint8_t driftSamples;     // Agreeing samples behind driftPpm
+    static uint32_t driftBaselineSec; // RTC run time behind driftPpm (sample weight)
+
+    // Drift correction added to the raw RTC reading at boot (not persisted)
+    static long rtcCorrectionSec;
+
+    // Update drift model + RTC after a sync; offset = true time - system clock before sync
+    static void recordTimeSync(time_t trueEpoch, long offsetSec);
+
+    // Fold a drift sample (raw RTC offset over its run time) into the model
+    static void addDriftSample(long rawOffsetSec, long elapsedSec);
+
+    // Error of the drift model in ppm (RTC_DRIFT_UNMODELED_PPM until trusted)
+    static float driftUncertaintyPpm();
+
+    // Load/save state from/to the state store; saveState() commits the store
     static void loadState();
     static void saveState();
 
+    // Read /sleep_state.json of earlier firmware (deleted afterwards)
+    static bool loadLegacyState();
+
 public:
     // Initialize sleep manager
     static void init();
 
-    // Read current epoch from BM8563 hardware RTC
+    // Read current epoch from BM8563 hardware RTC (drift-corrected)
     static time_t readHardwareRtc();
 
     // Write NTP-synced time to BM8563 hardware RTC
@@ -47,8 +72,19 @@ public:
     // Set last update success status
     static void setLastUpdateSuccess(bool success);
 
-    // Check if NTP sync is needed
+    // Check if NTP sync is needed (predicted clock error above TIME_SYNC_MAX_ERROR_SEC)
     static bool shouldSyncTime();
+
+    // Discipline system clock + hardware RTC from a server timestamp (HTTP Date header).
+    // Returns false if the offset is implausible and NTP should be used instead.
+    static bool applyServerTime(time_t serverEpoch);
+
+    // Record an NTP sync that already set the system clock
+    // (offset = NTP time - system clock before the sync)
+    static void applyNtpTime(time_t ntpEpoch, long offsetSec);
+
+    // True if the clock was disciplined during this wake
+    static bool isTimeSynced();
 };
 
 #endif  // SLEEP_MANAGER_H
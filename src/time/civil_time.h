@@ -0,0 +1,147 @@
+#ifndef CIVIL_TIME_H
+#define CIVIL_TIME_H
+
+#include <stdint.h>
+
+// UTC calendar arithmetic without the C library's timezone machinery.
+// mktime() interprets its input in the global TZ, so converting a UTC
+// string used to mean setenv("TZ")/tzset() around every call. Everything here is
+// pure and constexpr (days-from-civil after H. Hinnant), no Arduino
+// dependency, so the LAN hub can share it.
+//
+// Epochs are int64_t; callers narrow to time_t.
+
+struct CivilDateTime {
+    int16_t year;
+    uint8_t month;    // 1-12
+    uint8_t day;      // 1-31
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t weekday;  // 0 = Sunday
+};
+
+class CivilTime {
+public:
+    // Days since 1970-01-01 for a proleptic Gregorian date
+    static constexpr int64_t daysFromCivil(int year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yoe = (unsigned)(year - era * 400);                            // [0, 399]
+        const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;  // [0, 365]
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                    // [0, 146096]
+        return era * 146097 + (int64_t)doe - 719468;
+    }
+
+    static constexpr int64_t toEpoch(int year, unsigned month, unsigned day,
+                                     unsigned hour, unsigned minute, unsigned second) {
+        return daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    }
+
+    // Inverse of toEpoch (UTC)
+    static constexpr CivilDateTime fromEpoch(int64_t epoch) {
+        int64_t days = epoch / 86400;
+        int64_t secs = epoch % 86400;
+        if (secs < 0) {
+            secs += 86400;
+            days -= 1;
+        }
+
+        const int64_t z = days + 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = (unsigned)(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+
+        CivilDateTime result = {};
+        result.year = (int16_t)(yoe + era * 400 + (month <= 2));
+        result.month = (uint8_t)month;
+        result.day = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+        result.hour = (uint8_t)(secs / 3600);
+        result.minute = (uint8_t)(secs / 60 % 60);
+        result.second = (uint8_t)(secs % 60);
+        result.weekday = (uint8_t)((days % 7 + 11) % 7);  // 1970-01-01 was a Thursday
+        return result;
+    }
+
+    // "2025-12-26T13:00:00Z" (seconds optional, offset ignored), 0 on failure.
+    // Fields are checked left to right so a short string is never read past
+    // its terminator.
+    static constexpr int64_t parseISO8601(const char* str) {
+        if (!str) return 0;
+        const int year = digits(str, 4);
+        if (year < 0 || str[4] != '-') return 0;
+        const int month = digits(str + 5, 2);
+        if (month < 1 || month > 12 || str[7] != '-') return 0;
+        const int day = digits(str + 8, 2);
+        if (day < 1 || day > 31 || str[10] != 'T') return 0;
+        const int hour = digits(str + 11, 2);
+        if (hour < 0 || hour > 23 || str[13] != ':') return 0;
+        const int minute = digits(str + 14, 2);
+        if (minute < 0 || minute > 59) return 0;
+
+        int second = 0;
+        if (str[16] == ':') {
+            second = digits(str + 17, 2);
+            if (second < 0 || second > 60) return 0;
+        }
+        return toEpoch(year, month, day, hour, minute, second);
+    }
+
+    // RFC 1123 HTTP date "Thu, 26 Dec 2025 14:00:00 GMT", 0 on failure
+    static constexpr int64_t parseRFC1123(const char* str) {
+        if (!str) return 0;
+
+        // Skip the weekday: "Thu, "
+        while (*str && *str != ',') str++;
+        if (*str != ',') return 0;
+        str++;
+        while (*str == ' ') str++;
+
+        const int day = digits(str, 2);
+        if (day < 1 || day > 31 || str[2] != ' ') return 0;
+        const int month = monthFromName(str + 3);
+        if (month == 0 || str[6] != ' ') return 0;
+        const int year = digits(str + 7, 4);
+        if (year < 0 || str[11] != ' ') return 0;
+        const int hour = digits(str + 12, 2);
+        if (hour < 0 || hour > 23 || str[14] != ':') return 0;
+        const int minute = digits(str + 15, 2);
+        if (minute < 0 || minute > 59 || str[17] != ':') return 0;
+        const int second = digits(str + 18, 2);
+        if (second < 0 || second > 60) return 0;
+        return toEpoch(year, month, day, hour, minute, second);
+    }
+
+private:
+    // Fixed-width decimal field, -1 if any character is not a digit
+    static constexpr int digits(const char* str, int count) {
+        int value = 0;
+        for (int i = 0; i < count; i++) {
+            if (str[i] < '0' || str[i] > '9') return -1;
+            value = value * 10 + (str[i] - '0');
+        }
+        return value;
+    }
+
+    // "Jan".."Dec" -> 1..12, 0 if unknown (a terminator never matches,
+    // so reading stops there)
+    static constexpr int monthFromName(const char* str) {
+        const char names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        for (int i = 0; i < 12; i++) {
+            if (str[0] == names[i * 3] && str[1] == names[i * 3 + 1] && str[2] == names[i * 3 + 2]) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+};
+
+static_assert(CivilTime::daysFromCivil(1970, 1, 1) == 0, "epoch origin");
+static_assert(CivilTime::toEpoch(2000, 3, 1, 0, 0, 0) == 951868800, "leap year handling");
+static_assert(CivilTime::parseISO8601("2025-12-26T13:00:00Z") == 1766754000, "ISO8601");
+static_assert(CivilTime::parseRFC1123("Fri, 26 Dec 2025 13:00:00 GMT") == 1766754000, "RFC 1123");
+
+#endif  // CIVIL_TIME_H
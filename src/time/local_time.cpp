@@ -0,0 +1,223 @@
+#include "local_time.h"
+#include <Arduino.h>
+#include "../config.h"
+
+LocalTime::Transition LocalTime::transitions[LocalTime::MAX_TRANSITIONS];
+int LocalTime::transitionCount = 0;
+int32_t LocalTime::baseOffset = 0;
+int64_t LocalTime::rangeStart = 0;
+int64_t LocalTime::rangeEnd = 0;
+
+bool LocalTime::parsed = false;
+bool LocalTime::hasDst = false;
+int32_t LocalTime::stdOffset = 0;
+int32_t LocalTime::dstOffset = 0;
+LocalTime::Rule LocalTime::dstStart = {};
+LocalTime::Rule LocalTime::dstEnd = {};
+char LocalTime::stdName[8] = "UTC";
+char LocalTime::dstName[8] = "";
+
+// Zone abbreviation: "CET" or quoted "<+01>"
+static const char* parseName(const char* p, char* name, size_t size) {
+    size_t len = 0;
+    if (*p == '<') {
+        p++;
+        while (*p && *p != '>') {
+            if (len < size - 1) name[len++] = *p;
+            p++;
+        }
+        if (*p == '>') p++;
+    } else {
+        while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) {
+            if (len < size - 1) name[len++] = *p;
+            p++;
+        }
+    }
+    name[len] = '\0';
+    return p;
+}
+
+// [+-]hh[:mm[:ss]] in seconds
+static const char* parseSeconds(const char* p, int32_t& seconds) {
+    int sign = 1;
+    if (*p == '+' || *p == '-') {
+        sign = (*p == '-') ? -1 : 1;
+        p++;
+    }
+
+    int32_t parts[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+        if (*p < '0' || *p > '9') break;
+        while (*p >= '0' && *p <= '9') {
+            parts[i] = parts[i] * 10 + (*p - '0');
+            p++;
+        }
+        if (*p != ':' || i == 2) break;
+        p++;
+    }
+
+    seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+    return p;
+}
+
+// ",Mm.w.d[/time]"
+static const char* parseMonthRule(const char* p, uint8_t& month, uint8_t& week,
+                                  uint8_t& weekday, int32_t& time, bool& ok) {
+    ok = false;
+    if (*p != ',' || p[1] != 'M') return p;
+    p += 2;
+
+    int values[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+        if (*p < '0' || *p > '9') return p;
+        while (*p >= '0' && *p <= '9') {
+            values[i] = values[i] * 10 + (*p - '0');
+            p++;
+        }
+        if (i < 2) {
+            if (*p != '.') return p;
+            p++;
+        }
+    }
+    if (values[0] < 1 || values[0] > 12 || values[1] < 1 || values[1] > 5 || values[2] > 6) {
+        return p;
+    }
+
+    month = values[0];
+    week = values[1];
+    weekday = values[2];
+    time = 2 * 3600;  // POSIX default 02:00
+    if (*p == '/') {
+        p = parseSeconds(p + 1, time);
+    }
+
+    ok = true;
+    return p;
+}
+
+void LocalTime::parseRule() {
+    parsed = true;
+
+    // POSIX offsets are west of UTC ("CET-1" is UTC+1), store them east
+    const char* p = parseName(TIMEZONE, stdName, sizeof(stdName));
+    int32_t posixOffset = 0;
+    p = parseSeconds(p, posixOffset);
+    stdOffset = -posixOffset;
+
+    hasDst = false;
+    if (*p == '\0') {
+        ESP_LOGI("time", "Timezone %s: UTC%+ld s, no DST", stdName, (long)stdOffset);
+        return;
+    }
+
+    p = parseName(p, dstName, sizeof(dstName));
+    dstOffset = stdOffset + 3600;  // POSIX default: one hour ahead
+    if (*p != ',' && *p != '\0') {
+        p = parseSeconds(p, posixOffset);
+        dstOffset = -posixOffset;
+    }
+
+    bool startOk = false;
+    bool endOk = false;
+    p = parseMonthRule(p, dstStart.month, dstStart.week, dstStart.weekday, dstStart.time, startOk);
+    p = parseMonthRule(p, dstEnd.month, dstEnd.week, dstEnd.weekday, dstEnd.time, endOk);
+
+    if (!startOk || !endOk || dstName[0] == '\0') {
+        // Julian-day rules (Jn / n) are not used by any zone this dashboard targets
+        ESP_LOGW("time", "Unsupported DST rule in TIMEZONE \"%s\", using standard time only", TIMEZONE);
+        return;
+    }
+
+    hasDst = true;
+    ESP_LOGI("time", "Timezone %s/%s: UTC%+ld/%+ld s", stdName, dstName,
+             (long)stdOffset, (long)dstOffset);
+}
+
+int64_t LocalTime::ruleToUtc(int year, const Rule& rule, int32_t offsetBefore) {
+    // Day of month of the w-th weekday d (w = 5: last one in the month)
+    int64_t firstDay = CivilTime::daysFromCivil(year, rule.month, 1);
+    int64_t nextMonth = rule.month == 12 ? CivilTime::daysFromCivil(year + 1, 1, 1)
+                                         : CivilTime::daysFromCivil(year, rule.month + 1, 1);
+    int daysInMonth = (int)(nextMonth - firstDay);
+    int firstWeekday = (int)((firstDay % 7 + 11) % 7);  // 1970-01-01 was a Thursday
+
+    int day = 1 + (rule.weekday - firstWeekday + 7) % 7 + (rule.week - 1) * 7;
+    while (day > daysInMonth) day -= 7;
+
+    // The rule time is wall-clock time of the offset in effect before the change
+    return (firstDay + day - 1) * 86400 + rule.time - offsetBefore;
+}
+
+void LocalTime::build(int year) {
+    if (!parsed) parseRule();
+
+    transitionCount = 0;
+    rangeStart = CivilTime::daysFromCivil(year - 1, 1, 1) * 86400;
+    rangeEnd = CivilTime::daysFromCivil(year + 2, 1, 1) * 86400;
+
+    if (!hasDst) {
+        baseOffset = stdOffset;
+        return;
+    }
+
+    for (int y = year - 1; y <= year + 1; y++) {
+        Transition start = {ruleToUtc(y, dstStart, stdOffset), dstOffset, true};
+        Transition end = {ruleToUtc(y, dstEnd, dstOffset), stdOffset, false};
+
+        // Southern hemisphere zones end DST before they start it
+        if (start.utc < end.utc) {
+            transitions[transitionCount++] = start;
+            transitions[transitionCount++] = end;
+        } else {
+            transitions[transitionCount++] = end;
+            transitions[transitionCount++] = start;
+        }
+    }
+
+    // Before the first transition the opposite offset applies
+    baseOffset = transitions[0].dst ? stdOffset : dstOffset;
+}
+
+int LocalTime::find(time_t utc) {
+    if (!parsed || utc < rangeStart || utc >= rangeEnd) {
+        build(CivilTime::fromEpoch(utc).year);
+    }
+
+    for (int i = transitionCount - 1; i >= 0; i--) {
+        if (utc >= transitions[i].utc) return i;
+    }
+    return -1;
+}
+
+int32_t LocalTime::utcOffset(time_t utc) {
+    int index = find(utc);
+    return index >= 0 ? transitions[index].offset : baseOffset;
+}
+
+CivilDateTime LocalTime::breakdown(time_t utc) {
+    return CivilTime::fromEpoch((int64_t)utc + utcOffset(utc));
+}
+
+time_t LocalTime::startOfDay(time_t utc) {
+    int64_t local = (int64_t)utc + utcOffset(utc);
+    int64_t localMidnight = local - ((local % 86400) + 86400) % 86400;
+
+    // Offset at midnight can differ from the offset now on a DST-change day
+    int64_t candidate = localMidnight - utcOffset(utc);
+    return (time_t)(localMidnight - utcOffset(candidate));
+}
+
+time_t LocalTime::fromLocal(int year, unsigned month, unsigned day,
+                            unsigned hour, unsigned minute, unsigned second) {
+    int64_t local = CivilTime::toEpoch(year, month, day, hour, minute, second);
+
+    // Resolve with the offset that applies at the resulting instant
+    int64_t guess = local - utcOffset((time_t)local);
+    return (time_t)(local - utcOffset((time_t)guess));
+}
+
+const char* LocalTime::zoneName(time_t utc) {
+    int index = find(utc);
+    bool dst = index >= 0 ? transitions[index].dst : (hasDst && baseOffset == dstOffset);
+    return dst ? dstName : stdName;
+}
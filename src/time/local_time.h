@@ -0,0 +1,74 @@
+#ifndef LOCAL_TIME_H
+#define LOCAL_TIME_H
+
+#include <stdint.h>
+#include <time.h>
+#include "civil_time.h"
+
+// UTC -> local time from a small table of UTC offset transitions.
+//
+// The POSIX rule in TIMEZONE (config.h) is parsed once and expanded into
+// the transitions of the previous, current and next year. After that a
+// conversion is a scan over at most six entries and an add, instead of
+// newlib re-evaluating the rule string on every localtime()/mktime() call.
+// The table is rebuilt automatically for times outside that range, so no
+// init order has to be respected. TIMEZONE is the only place the zone is
+// defined; TZ in the environment is no longer used.
+class LocalTime {
+public:
+    // Offset from UTC in seconds at the given instant
+    static int32_t utcOffset(time_t utc);
+
+    // Local calendar fields of a UTC instant
+    static CivilDateTime breakdown(time_t utc);
+
+    // UTC instant of local midnight of the day containing utc
+    static time_t startOfDay(time_t utc);
+
+    // UTC instant of a local wall-clock time (mktime() replacement; hour may
+    // exceed 23 and carries into the next day)
+    static time_t fromLocal(int year, unsigned month, unsigned day,
+                            unsigned hour, unsigned minute, unsigned second);
+
+    // Abbreviation in effect at the given instant ("CET"/"CEST")
+    static const char* zoneName(time_t utc);
+
+private:
+    struct Transition {
+        int64_t utc;        // First second the offset applies
+        int32_t offset;     // Seconds east of UTC
+        bool dst;
+    };
+
+    // POSIX "Mm.w.d/time" rule
+    struct Rule {
+        uint8_t month;      // 1-12
+        uint8_t week;       // 1-5, 5 = last
+        uint8_t weekday;    // 0 = Sunday
+        int32_t time;       // Seconds after local midnight
+    };
+
+    static const int MAX_TRANSITIONS = 6;
+
+    static Transition transitions[MAX_TRANSITIONS];
+    static int transitionCount;
+    static int32_t baseOffset;      // Offset before the first transition
+    static int64_t rangeStart;      // Table valid for [rangeStart, rangeEnd)
+    static int64_t rangeEnd;
+
+    static bool parsed;
+    static bool hasDst;
+    static int32_t stdOffset;
+    static int32_t dstOffset;
+    static Rule dstStart;
+    static Rule dstEnd;
+    static char stdName[8];
+    static char dstName[8];
+
+    static void parseRule();
+    static int64_t ruleToUtc(int year, const Rule& rule, int32_t offsetBefore);
+    static void build(int year);
+    static int find(time_t utc);    // Index of the active transition, -1 = base
+};
+
+#endif  // LOCAL_TIME_H